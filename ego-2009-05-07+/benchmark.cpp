@@ -23,24 +23,32 @@
 
 #include "benchmark.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
 #include "fast_timer.h"
+#include "perf_counters.h"
 #include "playout.h"
+#include "sgf_scanner.h"
 #include "utils.h"
 
 namespace Benchmark {
 
   static const Board empty_board;
 
-  void do_playouts(uint playout_cnt, FastMap<Player, uint>* win_cnt) {
+  void do_playouts(const Board* start_board, uint playout_cnt,
+                   FastMap<Player, uint>* win_cnt, uint64* move_cnt) {
     static Board playout_board;
-    ExtPolicy policy(global_random);
+    ExtPolicy policy(thread_random ());
     Playout<ExtPolicy> playout(&policy, &playout_board);
 
     rep (ii, playout_cnt) {
-      playout_board.load (&empty_board);
+      playout_board.load (start_board);
       if (playout.run () == pass_pass) {
         (*win_cnt) [playout_board.winner ()] ++;
       }
+      *move_cnt += playout_board.move_no - start_board->move_no;
     }
 
     // ignore this line, this is for a stupid g++ to force aligning(?)
@@ -48,33 +56,133 @@ namespace Benchmark {
     unused(xxx);
   }
 
-  string run(uint playout_cnt) {
+  // main line of the first game in an SGF, all of it or its first
+  // max_move_cnt moves
+  bool load_sgf (const string& file_name, uint max_move_cnt, Board* board) {
+    SgfScanner scanner;
+    SgfGame    game;
+    if (!scanner.open (file_name)) return false;
+    if (!scanner.next_game (&game)) return false;
+    return game.replay (board, max_move_cnt);
+  }
+
+  bool load_position (const string& position, Board* board) {
+    string file_name = position;
+    uint   max_move_cnt = SgfGame::max_uint;
+
+    string::size_type colon = position.rfind (':');
+    if (colon != string::npos &&
+        string_to<uint> (position.substr (colon + 1), &max_move_cnt)) {
+      file_name = position.substr (0, colon);
+    }
+
+    if (file_name.size () >= 4 &&
+        file_name.substr (file_name.size () - 4) == ".sgf") {
+      return load_sgf (file_name, max_move_cnt, board);
+    }
+
+    ifstream in (file_name.c_str ());
+    return board->load_from_ascii (in);
+  }
+
+  string perf_report (PerfCounters& perf, uint playout_cnt, uint64 move_cnt) {
+    ostringstream ret;
+    if (!perf.any_available ()) {
+      ret << "hardware counters not available" << endl;
+      return ret.str ();
+    }
+
+    char buf [200];
+    rep (ii, PerfCounters::event_cnt) {
+      PerfCounters::Event e = PerfCounters::Event (ii);
+      if (!perf.is_available (e)) {
+        sprintf (buf, "%-14s not available", PerfCounters::event_name [e]);
+      } else {
+        sprintf (buf, "%-14s %12.1f per playout %8.2f per move",
+                 PerfCounters::event_name [e],
+                 perf.value (e) / double (playout_cnt),
+                 perf.value (e) / double (move_cnt));
+      }
+      ret << buf << endl;
+    }
+
+    if (perf.is_available (PerfCounters::instructions) &&
+        perf.is_available (PerfCounters::cycles) &&
+        perf.value (PerfCounters::cycles) > 0.0) {
+      ret << "IPC " << perf.value (PerfCounters::instructions) /
+                       perf.value (PerfCounters::cycles) << endl;
+    }
+    return ret.str ();
+  }
+
+  string run_position (const Board* start_board, uint playout_cnt,
+                       bool perf_counters, float* seconds) {
     FastMap<Player, uint>  win_cnt;
     FastTimer              fast_timer;
+    PerfCounters*          perf = perf_counters ? new PerfCounters : NULL;
+    uint64                 move_cnt = 0;
 
     player_for_each (pl) win_cnt [pl] = 0;
 
     fast_timer.reset ();
     fast_timer.start ();
     float seconds_begin = process_user_time ();
+    if (perf != NULL) perf->start ();
     
-    do_playouts(playout_cnt, &win_cnt);
+    do_playouts(start_board, playout_cnt, &win_cnt, &move_cnt);
 
+    if (perf != NULL) perf->stop ();
     float seconds_end = process_user_time ();
     fast_timer.stop ();
 
 
     float seconds_total = seconds_end - seconds_begin;
     float cc_per_playout = fast_timer.ticks () / double (playout_cnt);
+    *seconds = seconds_total;
     
     ostringstream ret;
-    ret << endl 
-        << playout_cnt << " playouts in " << seconds_total << " seconds" << endl
+    ret << playout_cnt << " playouts in " << seconds_total << " seconds" << endl
         << float (playout_cnt) / seconds_total / 1000.0 << " kpps" << endl
         << 1000000.0 / cc_per_playout  << " kpps/GHz (clock independent)" << endl
         << win_cnt [Player::black ()] << "/" << win_cnt [Player::white ()]
-        << " (black wins / white wins)" << endl;
+        << " (black wins / white wins)" << endl
+        << float (move_cnt) / float (playout_cnt) << " moves per playout" << endl;
+
+    if (perf != NULL) {
+      ret << perf_report (*perf, playout_cnt, move_cnt);
+      delete perf;
+    }
 
     return ret.str();
   }
+
+  string run(uint playout_cnt, bool perf_counters, const vector <string>& positions) {
+    float seconds;
+    if (positions.empty ()) {
+      return "\n" + run_position (&empty_board, playout_cnt, perf_counters, &seconds);
+    }
+
+    Board  board;
+    float  seconds_total = 0.0;
+    uint   position_cnt  = 0;
+
+    ostringstream ret;
+    ret << endl;
+    rep (ii, positions.size ()) {
+      ret << positions [ii] << ":" << endl;
+      if (!load_position (positions [ii], &board)) {
+        ret << "cannot load position" << endl << endl;
+        continue;
+      }
+      ret << run_position (&board, playout_cnt, perf_counters, &seconds) << endl;
+      seconds_total += seconds;
+      position_cnt++;
+    }
+
+    if (position_cnt > 0) {
+      ret << "all " << position_cnt << " positions: "
+          << float (playout_cnt) * position_cnt / seconds_total / 1000.0 << " kpps" << endl;
+    }
+    return ret.str ();
+  }
 }
@@ -2,11 +2,22 @@
 #define _BENCHMARK_H_
 
 #include <string>
+#include <vector>
 
 #include "board.h"
 
 namespace Benchmark {
-  string run (uint playout_cnt);
+  // Playouts from the empty board or from each position, reported for
+  // each position and together. A position is a load_from_ascii file or
+  // an SGF, "game.sgf:60" stops its main line after 60 moves.
+  //
+  // With perf_counters also instructions, cycles, branch and cache
+  // misses per playout and per move (Linux only).
+  string run (uint playout_cnt,
+              bool perf_counters = false,
+              const vector <string>& positions = vector <string> ());
+
+  bool load_position (const string& position, Board* board);
 }
 
 #endif
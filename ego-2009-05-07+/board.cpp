@@ -992,8 +992,13 @@ Player Board::is_ladder(Vertex atari, Player p) {
 all_inline
 Player Board::is_ladder_norec(Vertex atari0, Player p)
 {
-	static Board boards[50];  // UWAGA na watki !!
-	static Vertex ataris[50]; // UWAGA na watki !!
+	// Osobny stos dla kazdego watku (tryb --host)
+	static thread_local_pod Board*  boards = NULL;
+	static thread_local_pod Vertex* ataris = NULL;
+	if (boards == NULL) {
+		boards = new Board[50];
+		ataris = new Vertex[50];
+	}
 	uint stack_len = 1;
 	boards[0].load(this);
 	ataris[0] = atari0;
@@ -1208,4 +1213,7 @@ void Board::check_no_more_legal (Player player) { // at the end of the playout
       assert (is_eyelike (player, v) || is_pseudo_legal (player, v) == false);
 }
 
-const Zobrist Board::zobrist[1] = { Zobrist (global_random) };
+// Stala ziarno: hash planszy musi byc taki sam w kazdym procesie
+// (ksiazka otwarc jest zapisana wedlug niego).
+static FastRandom zobrist_random (0x20090507);
+const Zobrist Board::zobrist[1] = { Zobrist (zobrist_random) };
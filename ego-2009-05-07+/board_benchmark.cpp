@@ -0,0 +1,319 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "board_benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include "fast_random.h"
+#include "fast_timer.h"
+#include "utils.h"
+
+namespace BoardBenchmark {
+
+  static const uint corpus_seed     = 2009;
+  static const uint corpus_game_cnt = 16;
+  static const uint corpus_move_no [] = { 10, 40, 80, 120 };
+  static const uint moves_per_position = 8;
+
+  struct Result {
+    string  name;
+    double  calls;
+    double  cycles;
+    uint64  checksum;
+  };
+
+  // uniformly random non eyelike moves, like the last resort of ExtPolicy
+  static Vertex random_move (Board& board, FastRandom& random) {
+    Player pl = board.act_player ();
+    uint ii_start = random.rand_int (board.empty_v_cnt);
+    rep (dd, board.empty_v_cnt) {
+      Vertex v = board.empty_v [(ii_start + dd) % board.empty_v_cnt];
+      if (!board.is_eyelike (pl, v) && board.is_pseudo_legal (pl, v)) return v;
+    }
+    return Vertex::pass ();
+  }
+
+  static void make_corpus (vector <Board*>* corpus) {
+    FastRandom random (corpus_seed);
+    uint snapshot_cnt = sizeof (corpus_move_no) / sizeof (corpus_move_no [0]);
+
+    rep (game, corpus_game_cnt) {
+      Board board;
+      uint  snapshot = 0;
+      while (snapshot < snapshot_cnt && !board.both_player_pass ()) {
+        if (board.move_no == corpus_move_no [snapshot]) {
+          Board* position = new Board;
+          position->load (&board);
+          corpus->push_back (position);
+          snapshot++;
+        }
+        board.play_legal (board.act_player (), random_move (board, random));
+      }
+    }
+  }
+
+  // legal moves of the player to move, the same for every run
+  static void make_moves (const vector <Board*>& corpus,
+                          vector <pair <uint, Vertex> >* moves)
+  {
+    FastRandom random (corpus_seed);
+    rep (pos, corpus.size ()) {
+      Board board;
+      rep (ii, moves_per_position) {
+        board.load (corpus [pos]);
+        Vertex v = random_move (board, random);
+        if (v != Vertex::pass ()) moves->push_back (make_pair (pos, v));
+      }
+    }
+  }
+
+  // liberties of chains in atari, with their owner
+  static void make_ataris (const vector <Board*>& corpus,
+                           vector <pair <uint, pair <Vertex, Player> > >* ataris)
+  {
+    Vertex blacks [20], whites [20];
+    uint   blackc, whitec;
+    rep (pos, corpus.size ()) {
+      corpus [pos]->find_all_atari (blacks, whites, blackc, whitec, 20);
+      rep (ii, blackc)
+        ataris->push_back (make_pair (pos, make_pair (blacks [ii], Player::black ())));
+      rep (ii, whitec)
+        ataris->push_back (make_pair (pos, make_pair (whites [ii], Player::white ())));
+    }
+  }
+
+  static void add_result (vector <Result>* results, const char* name,
+                          double calls, FastTimer& timer, uint64 checksum)
+  {
+    Result r;
+    r.name     = name;
+    r.calls    = calls;
+    r.cycles   = timer.total_ticks () / calls;
+    r.checksum = checksum;
+    results->push_back (r);
+  }
+
+  static map <string, pair <double, uint64> > read_baseline (const string& file_name) {
+    map <string, pair <double, uint64> > baseline;
+    ifstream in (file_name.c_str ());
+    string line;
+    while (getline (in, line)) {
+      if (line.empty () || line [0] == '#') continue;
+      istringstream line_in (line);
+      string name;
+      double calls, cycles;
+      uint64 checksum;
+      if (line_in >> name >> calls >> cycles >> checksum)
+        baseline [name] = make_pair (cycles, checksum);
+    }
+    return baseline;
+  }
+
+  string run (uint rep_cnt, const string& baseline_file) {
+    vector <Board*> corpus;
+    vector <pair <uint, Vertex> > moves;
+    vector <pair <uint, pair <Vertex, Player> > > ataris;
+
+    make_corpus (&corpus);
+    make_moves (corpus, &moves);
+    make_ataris (corpus, &ataris);
+
+    vector <Result> results;
+    Board  board;
+    uint64 checksum;
+    double calls;
+
+    // load
+    {
+      FastTimer timer;
+      checksum = 0;
+      timer.start ();
+      rep (rr, rep_cnt) {
+        rep (pos, corpus.size ()) {
+          board.load (corpus [pos]);
+          checksum += board.empty_v_cnt;
+        }
+      }
+      timer.stop ();
+      calls = double (rep_cnt) * corpus.size ();
+      add_result (&results, "load", calls, timer, checksum);
+    }
+
+    // is_pseudo_legal, is_eyelike over all empty vertices, both players
+    {
+      FastTimer pseudo_legal_timer;
+      FastTimer eyelike_timer;
+      uint64 pseudo_legal_sum = 0;
+      uint64 eyelike_sum = 0;
+      calls = 0;
+      rep (pos, corpus.size ()) {
+        Board* position = corpus [pos];
+        rep (rr, rep_cnt) {
+          pseudo_legal_timer.start ();
+          rep (ii, position->empty_v_cnt) {
+            pseudo_legal_sum += position->is_pseudo_legal (Player::black (), position->empty_v [ii]);
+            pseudo_legal_sum += position->is_pseudo_legal (Player::white (), position->empty_v [ii]);
+          }
+          pseudo_legal_timer.stop ();
+          eyelike_timer.start ();
+          rep (ii, position->empty_v_cnt) {
+            eyelike_sum += position->is_eyelike (Player::black (), position->empty_v [ii]);
+            eyelike_sum += position->is_eyelike (Player::white (), position->empty_v [ii]);
+          }
+          eyelike_timer.stop ();
+        }
+        calls += 2.0 * rep_cnt * position->empty_v_cnt;
+      }
+      add_result (&results, "is_pseudo_legal", calls, pseudo_legal_timer, pseudo_legal_sum);
+      add_result (&results, "is_eyelike", calls, eyelike_timer, eyelike_sum);
+    }
+
+    // play_legal, try_play, undo: one timed call after an untimed load
+    {
+      FastTimer play_legal_timer;
+      FastTimer try_play_timer;
+      FastTimer undo_timer;
+      uint64 play_legal_sum = 0;
+      uint64 try_play_sum = 0;
+      uint64 undo_sum = 0;
+      rep (rr, rep_cnt) {
+        rep (ii, moves.size ()) {
+          Board* position = corpus [moves [ii].first];
+          Vertex v = moves [ii].second;
+
+          board.load (position);
+          play_legal_timer.start ();
+          board.play_legal (board.act_player (), v);
+          play_legal_timer.stop ();
+          play_legal_sum += board.empty_v_cnt + board.last_move_status;
+
+          board.load (position);
+          try_play_timer.start ();
+          bool ok = board.try_play (board.act_player (), v);
+          try_play_timer.stop ();
+          try_play_sum += ok + board.empty_v_cnt;
+
+          undo_timer.start ();
+          ok = board.undo ();
+          undo_timer.stop ();
+          undo_sum += ok + board.move_no;
+        }
+      }
+      calls = double (rep_cnt) * moves.size ();
+      add_result (&results, "play_legal", calls, play_legal_timer, play_legal_sum);
+      add_result (&results, "try_play", calls, try_play_timer, try_play_sum);
+      add_result (&results, "undo", calls, undo_timer, undo_sum);
+    }
+
+    // find_recent_atari, score, tt_score
+    {
+      FastTimer atari_timer;
+      FastTimer score_timer;
+      FastTimer tt_score_timer;
+      uint64 atari_sum = 0;
+      uint64 score_sum = 0;
+      uint64 tt_score_sum = 0;
+      Vertex blacks [10], whites [10];
+      uint   blackc, whitec;
+
+      rep (rr, rep_cnt) {
+        rep (pos, corpus.size ()) {
+          Board* position = corpus [pos];
+
+          atari_timer.start ();
+          position->find_recent_atari (blacks, whites, blackc, whitec, 10);
+          atari_timer.stop ();
+          atari_sum += blackc * 16 + whitec;
+
+          score_timer.start ();
+          int score = position->score ();
+          score_timer.stop ();
+          score_sum += score;
+
+          tt_score_timer.start ();
+          int tt_score = position->tt_score ();
+          tt_score_timer.stop ();
+          tt_score_sum += tt_score;
+        }
+      }
+      calls = double (rep_cnt) * corpus.size ();
+      add_result (&results, "find_recent_atari", calls, atari_timer, atari_sum);
+      add_result (&results, "score", calls, score_timer, score_sum);
+      add_result (&results, "tt_score", calls, tt_score_timer, tt_score_sum);
+    }
+
+    // is_ladder_norec on every chain in atari
+    if (ataris.size () > 0) {
+      FastTimer timer;
+      checksum = 0;
+      rep (rr, rep_cnt) {
+        rep (ii, ataris.size ()) {
+          Board* position = corpus [ataris [ii].first];
+          timer.start ();
+          Player winner = position->is_ladder_norec (ataris [ii].second.first,
+                                                     ataris [ii].second.second);
+          timer.stop ();
+          checksum += winner.get_idx () + 1;
+        }
+      }
+      calls = double (rep_cnt) * ataris.size ();
+      add_result (&results, "is_ladder_norec", calls, timer, checksum);
+    }
+
+    rep (pos, corpus.size ()) delete corpus [pos];
+
+    map <string, pair <double, uint64> > baseline;
+    if (baseline_file != "") baseline = read_baseline (baseline_file);
+
+    ostringstream out;
+    char buf [200];
+    out << "# primitive calls cycles_per_call checksum";
+    if (baseline_file != "") out << " baseline_cycles change";
+    out << endl;
+    out << "# " << corpus.size () << " positions, "
+        << moves.size () << " moves, "
+        << ataris.size () << " ataris, "
+        << rep_cnt << " repetitions" << endl;
+
+    rep (ii, results.size ()) {
+      sprintf (buf, "%-18s %10.0f %10.1f %20llu",
+               results [ii].name.c_str (), results [ii].calls,
+               results [ii].cycles, results [ii].checksum);
+      out << buf;
+      if (baseline.find (results [ii].name) != baseline.end ()) {
+        double base = baseline [results [ii].name].first;
+        sprintf (buf, " %10.1f %+7.1f%%", base, 100.0 * (results [ii].cycles - base) / base);
+        out << buf;
+        if (baseline [results [ii].name].second != results [ii].checksum)
+          out << " checksum_changed";
+      }
+      out << endl;
+    }
+
+    return out.str ();
+  }
+}
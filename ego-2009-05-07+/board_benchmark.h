@@ -0,0 +1,22 @@
+#ifndef _BOARD_BENCHMARK_H_
+#define _BOARD_BENCHMARK_H_
+
+#include <string>
+
+#include "board.h"
+
+// Times single Board primitives over a fixed corpus of positions (random
+// games from a fixed seed). One line per primitive:
+//
+//   <primitive> <calls> <cycles per call> <checksum>
+//
+// Lines starting with '#' are comments. When baseline_file (an earlier
+// output) is given, its cycles and the relative change are appended,
+// and "checksum_changed" when the primitive now returns different
+// results, not only faster or slower.
+
+namespace BoardBenchmark {
+  string run (uint rep_cnt, const string& baseline_file = "");
+}
+
+#endif
@@ -26,6 +26,8 @@
 #include "utils.cpp"
 
 #include "fast_timer.cpp"
+#include "search_profile.cpp"
+#include "perf_counters.cpp"
 #include "fast_random.cpp"
 
 #include "player.cpp"
@@ -36,9 +38,15 @@
 #include "hash.cpp"
 #include "board.cpp"
 #include "sgf.cpp"
+#include "sgf_scanner.cpp"
+#include "pattern.cpp"
+#include "pattern_learning.cpp"
+#include "opening_book.cpp"
 
 #include "playout.cpp"
 #include "benchmark.cpp"
+#include "board_benchmark.cpp"
+#include "pool_benchmark.cpp"
 
 #include "gtp.cpp"
 #include "basic_gtp.cpp"
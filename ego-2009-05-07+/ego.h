@@ -6,6 +6,8 @@
 
 #include "fast_pool.h"
 #include "fast_timer.h"
+#include "search_profile.h"
+#include "perf_counters.h"
 #include "fast_random.h"
 #include "fast_stack.h"
 #include "fast_map.h"
@@ -18,9 +20,15 @@
 #include "hash.h"
 #include "board.h"
 #include "sgf.h"
+#include "sgf_scanner.h"
+#include "pattern.h"
+#include "pattern_learning.h"
+#include "opening_book.h"
 
 #include "playout.h"
 #include "benchmark.h"
+#include "board_benchmark.h"
+#include "pool_benchmark.h"
 
 #include "gtp.h"
 
@@ -4,40 +4,223 @@
 #include "utils.h"
 #include "testing.h"
 
+#include <pthread.h>
+
+#ifdef _MSC_VER
+#include <cstdlib>
+#else
+#include <sys/mman.h>
+#endif
+
+// Memory of the pool is allocated once and starts zero filled; no
+// constructors or destructors of elt_t are called. Elements are handed
+// out from an untouched region first, so reset is O(1).
+
 template <class elt_t> class FastPool {
 public:
-  FastPool (uint pool_size) {
+  static const uint64 huge_page_size = 2 * 1024 * 1024;
+
+  FastPool (uint pool_size, bool huge_pages = false, bool prefault = false) {
     this->pool_size = pool_size;
-    memory   = new elt_t  [pool_size];
+    memory_size = uint64 (pool_size) * sizeof (elt_t);
+    memory   = allocate (huge_pages, prefault);
     free_elt = new elt_t* [pool_size];
+    reset ();
   }
 
   void reset() {
-    free_elt_count = pool_size;
-    rep (i, pool_size) free_elt [i] = memory + i;
+    used_elt_count = 0;
+    free_elt_count = 0;
   }
 
   ~FastPool () {
-    delete [] memory;
+#ifdef _MSC_VER
+    ::free (memory);
+#else
+    munmap (memory, memory_size);
+#endif
     delete [] free_elt;
   }
 
-  elt_t* malloc () { 
-    assertc (pool_ac, free_elt_count > 0);
-    return free_elt [--free_elt_count]; 
+  elt_t* malloc () {
+    if (free_elt_count > 0) return free_elt [--free_elt_count];
+    assertc (pool_ac, used_elt_count < pool_size);
+    return memory + used_elt_count++;
   }
 
-  void free (elt_t* elt) { 
-    free_elt [free_elt_count++] = elt;  
+  void free (elt_t* elt) {
+    free_elt [free_elt_count++] = elt;
+  }
+
+  // n consecutive elements from the untouched region, NULL without room
+  elt_t* malloc_bulk (uint n) {
+    if (pool_size - used_elt_count < n) return NULL;
+    elt_t* ret = memory + used_elt_count;
+    used_elt_count += n;
+    return ret;
+  }
+
+  bool can_malloc (uint n) const {
+    return free_elt_count + (pool_size - used_elt_count) >= n;
+  }
+
+  uint size () const {
+    return pool_size;
   }
 
 private:
-  uint pool_size;
 
-  elt_t* memory;
+  elt_t* allocate (bool huge_pages, bool prefault) {
+#ifdef _MSC_VER
+    unused (huge_pages);
+    unused (prefault);
+    return (elt_t*) calloc (pool_size, sizeof (elt_t));
+#else
+    void* ptr = MAP_FAILED;
+    int   populate = 0;
+#ifdef MAP_POPULATE
+    if (prefault) populate = MAP_POPULATE;
+#endif
+
+#ifdef MAP_HUGETLB
+    // needs reserved huge pages (vm.nr_hugepages), often there are none
+    if (huge_pages) {
+      memory_size = (memory_size + huge_page_size - 1) / huge_page_size * huge_page_size;
+      ptr = mmap (NULL, memory_size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+    }
+#endif
+
+    if (ptr == MAP_FAILED) {
+      ptr = mmap (NULL, memory_size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | populate, -1, 0);
+      if (ptr == MAP_FAILED) fatal_error ("FastPool: mmap failed");
+#ifdef MADV_HUGEPAGE
+      // transparent huge pages instead
+      if (huge_pages) madvise (ptr, memory_size, MADV_HUGEPAGE);
+#endif
+    }
+
+    if (prefault && populate == 0) {
+      for (uint64 ii = 0; ii < memory_size; ii += 4096) ((volatile char*) ptr) [ii] = 0;
+    }
+    return (elt_t*) ptr;
+#endif
+  }
+
+  uint    pool_size;
+  uint64  memory_size;
+
+  elt_t*  memory;
+  uint    used_elt_count;
 
   elt_t** free_elt;
   uint    free_elt_count;
 };
 
+// ----------------------------------------------------------------------
+
+// FastPool shared by many threads. Each thread allocates through its own
+// Magazine of free elements without any locking; magazines are refilled
+// from and returned to the central pool in batches under a mutex. An
+// element is always either in the central pool, in exactly one magazine
+// or in use, so it is never handed out twice (--pool-benchmark checks).
+
+template <class elt_t> class SharedPool {
+public:
+  static const uint magazine_size = 64;
+  static const uint batch_size    = magazine_size / 2;
+
+  class Magazine {
+  public:
+    Magazine (SharedPool& pool_) : pool (pool_), count (0) { }
+
+    ~Magazine () { flush (); }
+
+    // NULL when the central pool is exhausted too; other magazines may
+    // still hold up to magazine_size free elements each
+    elt_t* malloc () {
+      if (count == 0) count = pool.refill (elt, batch_size);
+      if (count == 0) return NULL;
+      return elt [--count];
+    }
+
+    void free (elt_t* e) {
+      if (count == magazine_size) {
+        count -= batch_size;
+        pool.drain (elt + count, batch_size);
+      }
+      elt [count++] = e;
+    }
+
+    // not exact when other threads allocate at the same time
+    bool can_malloc (uint n) const {
+      return count >= n || pool.can_malloc (n - count);
+    }
+
+    // returns everything to the central pool
+    void flush () {
+      pool.drain (elt, count);
+      count = 0;
+    }
+
+    // after SharedPool::reset the elements are owned by the pool again
+    void clear () {
+      count = 0;
+    }
+
+  private:
+    SharedPool& pool;
+    elt_t*      elt [magazine_size];
+    uint        count;
+  };
+
+  SharedPool (uint pool_size, bool huge_pages = false, bool prefault = false)
+    : central (pool_size, huge_pages, prefault)
+  {
+    pthread_mutex_init (&mutex, NULL);
+  }
+
+  ~SharedPool () {
+    pthread_mutex_destroy (&mutex);
+  }
+
+  // no thread may use the pool at that time, magazines have to be cleared
+  void reset () {
+    central.reset ();
+  }
+
+  bool can_malloc (uint n) {
+    pthread_mutex_lock (&mutex);
+    bool ret = central.can_malloc (n);
+    pthread_mutex_unlock (&mutex);
+    return ret;
+  }
+
+  uint size () const {
+    return central.size ();
+  }
+
+private:
+  friend class Magazine;
+
+  uint refill (elt_t** out, uint n) {
+    pthread_mutex_lock (&mutex);
+    uint cnt = 0;
+    while (cnt < n && central.can_malloc (1)) out [cnt++] = central.malloc ();
+    pthread_mutex_unlock (&mutex);
+    return cnt;
+  }
+
+  void drain (elt_t** in, uint n) {
+    if (n == 0) return;
+    pthread_mutex_lock (&mutex);
+    rep (ii, n) central.free (in [ii]);
+    pthread_mutex_unlock (&mutex);
+  }
+
+  FastPool <elt_t>  central;
+  pthread_mutex_t   mutex;
+};
+
 #endif
@@ -25,65 +25,91 @@
 #include "testing.h"
 #include "cstdio"
 
-const int FastRandom::cnt = (uint(1)<<31) - 1;
-
-//tr1::minstd_rand0 mt; // this is eqivalent when #include <tr1/random>
+//tr1::minstd_rand0 mt; // Park - Miller, used before; 31 bits and slower
 
 #include <sys/time.h>
 
+static inline uint64 rotl (uint64 x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
 FastRandom::FastRandom () {
 	struct timeval t;
 	gettimeofday(&t, 0);
-	seed = t.tv_usec;
+	set_seed (t.tv_usec);
 }
 
 FastRandom::FastRandom (uint seed_) {
-  seed = seed_; 
+  set_seed (seed_);
 }
 
+// state is expanded from the seed with splitmix64
 void FastRandom::set_seed (uint seed_) { 
   seed = seed_; 
+  uint64 x = seed_;
+  rep (ii, 4) {
+    uint64 z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    state [ii] = z ^ (z >> 31);
+  }
 }
 
 uint FastRandom::get_seed () { 
   return seed; 
 }
 
-uint FastRandom::rand_int () {       // a number between  0 ... cnt - 1
-  uint hi, lo;
-  lo = 16807 * (seed & 0xffff);
-  hi = 16807 * (seed >> 16);
-  lo += (hi & 0x7fff) << 16;
-  lo += hi >> 15;
-  seed = (lo & 0x7FFFFFFF) + (lo >> 31);
-  return seed;
-  //return mt (); // equivalen
+FastRandom FastRandom::stream (uint id) {
+  FastRandom ret (seed);
+  rep (ii, id) ret.jump ();
+  return ret;
 }
 
-// n must be between 1 .. (1<<16) + 1
-uint FastRandom::rand_int (uint n) { // 0 .. n-1
-  assertc (fast_random_ac, n > 0);
-  assertc (fast_random_ac, n <= (1<<16)+1);
-  return ((rand_int () & 0xffff) * n) >> 16;
+// equivalent to 2^128 calls of rand_uint64
+void FastRandom::jump () {
+  static const uint64 jump_poly [4] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+  };
+
+  uint64 s [4] = { 0, 0, 0, 0 };
+  rep (ii, 4) {
+    rep (bit, 64) {
+      if (jump_poly [ii] & (uint64 (1) << bit)) {
+        rep (jj, 4) s [jj] ^= state [jj];
+      }
+      rand_uint64 ();
+    }
+  }
+  rep (jj, 4) state [jj] = s [jj];
+}
+
+uint64 FastRandom::rand_uint64 () {
+  uint64 result = rotl (state [1] * 5, 7) * 9;
+  uint64 t = state [1] << 17;
+  state [2] ^= state [0];
+  state [3] ^= state [1];
+  state [1] ^= state [2];
+  state [0] ^= state [3];
+  state [2] ^= t;
+  state [3] = rotl (state [3], 45);
+  return result;
 }
 
-void FastRandom::test () {
-  uint start = rand_int ();
+uint FastRandom::rand_int () {       // a number between  0 ... 2^32 - 1
+  return uint (rand_uint64 () >> 32);
+}
 
-  uint n = 1;
-  uint max = 0;
-  uint sum = start;
+// multiply and shift instead of modulo, bias is below 2^-32 * n
+uint FastRandom::rand_int (uint n) { // 0 .. n-1
+  assertc (fast_random_ac, n > 0);
+  return uint ((uint64 (rand_int ()) * n) >> 32);
+}
 
-  while (true) {
-    uint r = rand_int ();
-    if (r == start) break;
-    n++;
-    sum += r;
-    if (max < r) max = r;
-  }
-  printf ("n = %d\n", n);
-  printf ("max = %d\n", max);
-  printf ("sum = %d\n", sum);
+void FastRandom::rand_int2 (uint n1, uint n2, uint* r1, uint* r2) {
+  uint64 r = rand_uint64 ();
+  *r1 = uint ((uint64 (uint (r >> 32)) * n1) >> 32);
+  *r2 = uint ((uint64 (uint (r))       * n2) >> 32);
 }
 
 void FastRandom::test2 (uint k, uint n) {
@@ -100,3 +126,14 @@ void FastRandom::test2 (uint k, uint n) {
 }
 
 FastRandom global_random;
+
+static thread_local_pod FastRandom* thread_random_ptr = NULL;
+
+FastRandom& thread_random () {
+  return thread_random_ptr != NULL ? *thread_random_ptr : global_random;
+}
+
+void set_thread_random_stream (uint id) {
+  delete thread_random_ptr;
+  thread_random_ptr = new FastRandom (global_random.stream (id));
+}
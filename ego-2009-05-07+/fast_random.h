@@ -3,10 +3,10 @@
 
 #include "utils.h"
 
-class FastRandom {             // Park - Miller "minimal standard"
+class FastRandom {             // xoshiro256** (Blackman, Vigna)
 
-  static const int cnt;
-  uint seed;
+  uint64 state [4];
+  uint   seed;
 
 public:
 
@@ -15,15 +15,30 @@ public:
   void set_seed (uint seed_);
   uint get_seed ();
 
+  // independent stream number id of the generator seeded with get_seed (),
+  // 2^128 numbers apart from other streams
+  FastRandom stream (uint id);
+  void jump ();
+
+  uint64 rand_uint64 ();
+
   uint rand_int ();
 
-  // n must be between 1 .. (1<<16) + 1
+  // n must be between 1 .. 2^32 - 1
   uint rand_int (uint n);
+
+  // two numbers from one 64 bit draw, for playout loops
+  void rand_int2 (uint n1, uint n2, uint* r1, uint* r2);
   
-  void test ();
   void test2 (uint k, uint n);
 };
 
 extern FastRandom global_random;
 
+// Random stream of the calling thread: global_random, unless the thread
+// called set_thread_random_stream, then global_random.stream (id). One
+// --seed reproduces all threads as long as ids are given deterministically.
+FastRandom& thread_random ();
+void set_thread_random_stream (uint id);
+
 #endif
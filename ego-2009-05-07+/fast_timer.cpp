@@ -73,6 +73,10 @@ void FastTimer::stop () {
 
 double FastTimer::ticks () { return sample_sum / sample_cnt; }
 
+double FastTimer::samples () { return sample_cnt; }
+
+double FastTimer::total_ticks () { return sample_sum; }
+
 string FastTimer::to_string (float unit) {
   ostringstream s;
   s.precision(15);
@@ -12,6 +12,8 @@ public:
   void   start ();
   void   stop ();
   double ticks ();
+  double samples ();
+  double total_ticks ();
   string to_string (float unit = 1.0);
 
 private:
@@ -8,10 +8,24 @@
 template <typename engine_t>
 class GenmoveGtp : public GtpCommand {
 public:
-  GenmoveGtp (Gtp& gtp, Board& board_) : board (board_) { //, engine (engine_)
+  GenmoveGtp (Gtp& gtp_, Board& board_) : gtp (gtp_), board (board_) { //, engine (engine_)
     gtp.add_gtp_command (this, "genmove");
+    engine = NULL;
   } 
 
+  virtual ~GenmoveGtp () {
+    delete engine;
+  }
+
+  // created on first use and kept, the engine is expensive
+  engine_t* get_engine () {
+    if (engine == NULL) {
+      engine = new engine_t (board);
+      engine->interrupt = gtp.interrupt_flag ();
+    }
+    return engine;
+  }
+
   virtual GtpResult exec_command (const string& command, istream& params) {
 
     if (command == "genmove") {
@@ -19,10 +33,7 @@ public:
       Vertex   v;
       if (!(params >> player)) return GtpResult::syntax_error ();
   
-      engine_t* engine = new engine_t (board); 
-      // TODO we don't need to allocate each time
-      v = engine->genmove (player);
-      delete engine;
+      v = get_engine ()->genmove (player);
 
       if (v != Vertex::resign () &&
           board.try_play (player, v) == false) {
@@ -36,7 +47,9 @@ public:
   } 
 
 private:
-  Board& board;
+  Gtp&      gtp;
+  Board&    board;
+  engine_t* engine;
 };
 
 #endif
@@ -47,12 +47,22 @@ GtpResult GtpResult::quit () {
   return GtpResult (status_quit);
 }
 
+GtpResult GtpResult::streamed () {
+  return GtpResult (status_streamed);
+}
+
+GtpResult GtpResult::deferred () {
+  return GtpResult (status_deferred);
+}
+
 bool GtpResult::quit_loop () {
   return status_ == status_quit;
 }
 
-string GtpResult::to_string () {
-  return status_marker () + " " + response_ + "\n\n";
+string GtpResult::to_string (const string& id) {
+  if (status_ == status_streamed) return "\n"; // marker already sent
+  if (status_ == status_deferred) return "";   // answered later
+  return status_marker () + id + " " + response_ + "\n\n";
 }
 
 string GtpResult::status_marker () {
@@ -60,6 +70,8 @@ string GtpResult::status_marker () {
   case status_success: return "=";
   case status_failure: return "?";
   case status_quit:    return "=";
+  case status_streamed: return "";
+  case status_deferred: return "";
   default: assert (false);
   }
 }
@@ -154,6 +166,26 @@ Gtp::Gtp () {
   add_static_command ("protocol_version", "2");
   add_static_command ("name", "libego");
   add_static_command ("gogui_analyze_commands", ""); // to be extended
+
+  add_immediate_command ("help");
+  add_immediate_command ("list_commands");
+  add_immediate_command ("known_command");
+  add_immediate_command ("echo");
+
+  interrupt = false;
+  running_interruptible = false;
+  running = false;
+  async = false;
+  current_out = NULL;
+  pthread_mutex_init (&async_mutex, NULL);
+  pthread_mutex_init (&out_mutex, NULL);
+  pthread_cond_init (&async_cond, NULL);
+}
+
+Gtp::~Gtp () {
+  pthread_cond_destroy (&async_cond);
+  pthread_mutex_destroy (&out_mutex);
+  pthread_mutex_destroy (&async_mutex);
 }
 
 bool Gtp::is_command (string name) {
@@ -212,6 +244,63 @@ void Gtp::add_gogui_param_bool (string cmd_name, string param_name, bool* ptr) {
   command_to_gogui_params[cmd_name].push_back (GoguiParam::Bool(param_name, ptr));
 }
 
+void Gtp::add_immediate_command (string name) {
+  immediate_commands.insert (name);
+}
+
+bool Gtp::is_immediate_command (string name) {
+  return
+    is_static_command (name) ||
+    immediate_commands.find (name) != immediate_commands.end ();
+}
+
+void Gtp::add_interruptible_command (string name) {
+  interruptible_commands.insert (name);
+}
+
+bool Gtp::is_interruptible_command (string name) {
+  return interruptible_commands.find (name) != interruptible_commands.end ();
+}
+
+bool Gtp::interrupted () const {
+  return interrupt;
+}
+
+const volatile bool* Gtp::interrupt_flag () const {
+  return &interrupt;
+}
+
+bool Gtp::is_async () const {
+  return async;
+}
+
+void Gtp::stream_begin () {
+  write (*current_out, "=" + current_id + "\n");
+}
+
+void Gtp::stream (const string& line) {
+  write (*current_out, line + "\n");
+}
+
+string Gtp::current_command_id () const {
+  return current_id;
+}
+
+void Gtp::respond (const string& id, GtpResult result) {
+  write (*async_out, result.to_string (id));
+}
+
+void Gtp::interrupt_command (bool value) {
+  interrupt = value;
+}
+
+GtpResult Gtp::exec_line (string line) {
+  preprocess (&line);
+  string id, cmd_name, params;
+  if (!split_line (line, &id, &cmd_name, &params)) return GtpResult::syntax_error ();
+  return run_command (cmd_name, params);
+}
+
 bool Gtp::run_file (string file_name, ostream& out) {
   ifstream in (file_name.data ());
   if (in) {
@@ -230,21 +319,139 @@ void Gtp::run_loop (istream& in, ostream& out, bool echo_commands) {
     if (echo_commands) out << line << endl;
     preprocess (&line);
 
-    istringstream line_stream (line);
-    string cmd_name;
-    if (!(line_stream >> cmd_name)) continue; // empty line - continue
+    string id, cmd_name, params;
+    if (!split_line (line, &id, &cmd_name, &params)) continue; // empty line
+
+    // nested loops (run_gtp_file) redirect the output
+    ostream* save_out = current_out;
+    string   save_id  = current_id;
+    current_out = &out;
+    current_id  = id;
+    GtpResult result = run_command (cmd_name, params);
+    current_out = save_out;
+    current_id  = save_id;
+
+    out << result.to_string (id);
 
-    if (!is_command (cmd_name)) {
-      out << GtpResult::failure("unknown command: \"" + cmd_name + "\"").to_string ();
+    if (result.quit_loop ()) break;
+  }
+}
+
+// optional numeric id, command name and the rest of the line
+bool Gtp::split_line (const string& line, string* id, string* cmd_name, string* params) {
+  istringstream line_stream (line);
+  if (!(line_stream >> *cmd_name)) return false;
+
+  if (cmd_name->find_first_not_of ("0123456789") == string::npos) {
+    *id = *cmd_name;
+    if (!(line_stream >> *cmd_name)) return false;
+  }
+
+  streamoff pos = line_stream.tellg ();
+  *params = pos < 0 ? "" : line.substr (pos);
+  return true;
+}
+
+GtpResult Gtp::run_command (const string& cmd_name, const string& params) {
+  if (!is_command (cmd_name)) {
+    return GtpResult::failure("unknown command: \"" + cmd_name + "\"");
+  }
+
+  istringstream params_stream (params);
+  GtpCommand* command = (*(command_of_name.find (cmd_name))).second;
+  return command->exec_command (cmd_name, params_stream);
+}
+
+void Gtp::write (ostream& out, const string& response) {
+  pthread_mutex_lock (&out_mutex);
+  out << response << flush;
+  pthread_mutex_unlock (&out_mutex);
+}
+
+void* Gtp::async_reader (void* gtp_ptr) {
+  Gtp* gtp = (Gtp*) gtp_ptr;
+
+  while (true) {
+    string line;
+    if (!getline (*gtp->async_in, line)) break;
+    gtp->preprocess (&line);
+
+    QueuedCommand cmd;
+    if (!gtp->split_line (line, &cmd.id, &cmd.cmd_name, &cmd.params)) continue;
+
+    // an answer must not overtake earlier commands (or land in a stream)
+    pthread_mutex_lock (&gtp->async_mutex);
+    if (gtp->is_immediate_command (cmd.cmd_name) &&
+        !gtp->running && gtp->async_queue.empty ()) {
+      GtpResult result = gtp->run_command (cmd.cmd_name, cmd.params);
+      gtp->write (*gtp->async_out, result.to_string (cmd.id));
+      pthread_mutex_unlock (&gtp->async_mutex);
       continue;
     }
 
-    GtpCommand* command = (*(command_of_name.find (cmd_name))).second;
-    GtpResult result = command->exec_command (cmd_name, line_stream);
-    out << result.to_string ();
+    if (gtp->running_interruptible) gtp->interrupt = true;
+    gtp->async_queue.push_back (cmd);
+    pthread_cond_signal (&gtp->async_cond);
+    pthread_mutex_unlock (&gtp->async_mutex);
+  }
+
+  // eof doesn't interrupt, queued commands are finished first
+  pthread_mutex_lock (&gtp->async_mutex);
+  gtp->async_eof = true;
+  pthread_cond_signal (&gtp->async_cond);
+  pthread_mutex_unlock (&gtp->async_mutex);
+  return NULL;
+}
+
+void Gtp::run_loop_async (istream& in, ostream& out) {
+  async_in    = &in;
+  async_out   = &out;
+  current_out = &out;
+  async_eof   = false;
+  async_queue.clear ();
 
+  pthread_t reader;
+  if (pthread_create (&reader, NULL, async_reader, this) != 0) {
+    run_loop (in, out);
+    return;
+  }
+  async = true;
+
+  while (true) {
+    pthread_mutex_lock (&async_mutex);
+    while (async_queue.empty () && !async_eof)
+      pthread_cond_wait (&async_cond, &async_mutex);
+
+    if (async_queue.empty ()) {
+      pthread_mutex_unlock (&async_mutex);
+      break;
+    }
+
+    QueuedCommand cmd = async_queue.front ();
+    async_queue.pop_front ();
+
+    // an interruptible command with something queued behind it is
+    // cancelled right away, a new position from a gui makes old analysis moot
+    running_interruptible = is_interruptible_command (cmd.cmd_name);
+    interrupt = running_interruptible && !async_queue.empty ();
+    running    = true;
+    current_id = cmd.id;
+    pthread_mutex_unlock (&async_mutex);
+
+    GtpResult result = run_command (cmd.cmd_name, cmd.params);
+
+    pthread_mutex_lock (&async_mutex);
+    running_interruptible = false;
+    interrupt = false;
+    write (out, result.to_string (cmd.id));
+    running = false;
+    pthread_mutex_unlock (&async_mutex);
     if (result.quit_loop ()) break;
   }
+
+  // the reader may still be blocked on input
+  pthread_detach (reader);
+  async = false;
 }
 
 GtpResult Gtp::exec_command (const string& command, istream& params) {
@@ -3,8 +3,12 @@
 
 #include <vector>
 #include <map>
+#include <set>
+#include <deque>
 #include <string>
 
+#include <pthread.h>
+
 #include "utils.h"
 
 using namespace std;
@@ -18,15 +22,19 @@ public:
   static GtpResult failure (string response = "");
   static GtpResult syntax_error ();
   static GtpResult quit ();
+  static GtpResult streamed ();
+  static GtpResult deferred ();
 
   bool quit_loop ();
-  string to_string ();
+  string to_string (const string& id = "");
 
 private:
   enum Status {
     status_success,
     status_failure,
-    status_quit
+    status_quit,
+    status_streamed,
+    status_deferred
   };
 
   string status_marker ();
@@ -82,7 +90,7 @@ public:
 class Gtp : public GtpCommand {
 public:
   Gtp ();
-  virtual ~Gtp () {};
+  virtual ~Gtp ();
   bool is_command (string name);
   bool is_static_command (string name);
   bool is_gogui_param_command (string name);
@@ -96,18 +104,87 @@ public:
   void add_gogui_param_uint (string cmd_name, string param_name, uint* ptr);
   void add_gogui_param_bool (string cmd_name, string param_name, bool* ptr);
 
+  // immediate commands only read state, the asynchronous loop answers
+  // them from the reader thread when nothing runs or waits; otherwise
+  // they are queued like the rest, so answers keep the order of commands
+  void add_immediate_command (string name);
+  bool is_immediate_command (string name);
+
+  // interruptible commands (analysis, pondering) are cancelled as soon
+  // as any other command arrives; everything else runs to completion,
+  // quit included is only executed after it
+  void add_interruptible_command (string name);
+  bool is_interruptible_command (string name);
+
+  // long running commands should poll this and return early
+  bool interrupted () const;
+  const volatile bool* interrupt_flag () const;
+  bool is_async () const;
+
+  // streaming commands (lz-analyze style) write the success marker and
+  // then any number of lines while still running, and return
+  // GtpResult::streamed () which only terminates the response
+  void stream_begin ();
+  void stream (const string& line);
+
+  // commands executed by other threads (host mode) return
+  // GtpResult::deferred () and later answer through respond
+  string current_command_id () const;
+  void respond (const string& id, GtpResult result);
+
+  // cancels whatever is running (host mode shutdown)
+  void interrupt_command (bool value = true);
+
+  // single command line, without id
+  GtpResult exec_line (string line);
+
   bool run_file (string file_name, ostream& out);
   void run_loop (istream& in, ostream& out, bool echo_commands = false);
 
+  // reads commands in a separate thread and executes them in the
+  // calling one, see comments at add_*_command
+  void run_loop_async (istream& in, ostream& out);
+
   virtual GtpResult exec_command (const string& command, istream& params);
 
 private:
 
   void preprocess (string* s);
+  bool split_line (const string& line, string* id, string* cmd_name, string* params);
+  GtpResult run_command (const string& cmd_name, const string& params);
+
+  static void* async_reader (void* gtp);
+  void write (ostream& out, const string& response);
 
   map <string, GtpCommand*>          command_of_name;
   map <string, string>               command_to_response;
   map <string, vector<GoguiParam> >  command_to_gogui_params;
+
+  set <string>  immediate_commands;
+  set <string>  interruptible_commands;
+
+  // output and id of the command being executed
+  ostream*      current_out;
+  string        current_id;
+
+  // asynchronous loop state, guarded by async_mutex
+  struct QueuedCommand {
+    string id;
+    string cmd_name;
+    string params;
+  };
+
+  istream*              async_in;
+  ostream*              async_out;
+  bool                  async;
+  deque<QueuedCommand>  async_queue;
+  bool                  async_eof;
+  bool                  running_interruptible;
+  bool                  running;     // popped and not answered yet
+  volatile bool         interrupt;
+  pthread_mutex_t       async_mutex;
+  pthread_mutex_t       out_mutex;
+  pthread_cond_t        async_cond;
 };
 
 #endif
@@ -29,11 +29,7 @@ uint Hash::index () const { return hash; }
 uint Hash::lock  () const { return hash >> 32; }
 
 void Hash::randomize (FastRandom& fr) { 
-  hash =
-    (uint64 (fr.rand_int ()) << (0*16)) ^
-    (uint64 (fr.rand_int ()) << (1*16)) ^ 
-    (uint64 (fr.rand_int ()) << (2*16)) ^ 
-    (uint64 (fr.rand_int ()) << (3*16));
+  hash = fr.rand_uint64 ();
 }
 
 void Hash::set_zero () { hash = 0; }
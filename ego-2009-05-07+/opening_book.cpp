@@ -0,0 +1,146 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "opening_book.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+OpeningBook* opening_book = NULL;
+
+// magic, entry count, komi, then 8 byte aligned entries
+struct BookHeader {
+  char      magic [8];
+  uint32_t  entry_cnt;
+  float     komi;
+};
+
+static const char book_file_magic [8] = { 'E', 'G', 'O', 'B', 'O', 'O', 'K', '1' };
+
+static const uint64 white_to_move_key = 0x9e3779b97f4a7c15ULL;
+
+static bool entry_less (const BookEntry& a, const BookEntry& b) {
+  return a.key < b.key;
+}
+
+OpeningBook::OpeningBook ()
+  : data (NULL), data_size (0), entries (NULL), entry_cnt (0), book_komi (0.0)
+{
+}
+
+OpeningBook::~OpeningBook () {
+  close ();
+}
+
+bool OpeningBook::open (const string& file_name) {
+  close ();
+#ifdef _MSC_VER
+  unused (file_name);
+  return false;
+#else
+  int fd = ::open (file_name.c_str (), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat (fd, &st) != 0 || uint64 (st.st_size) < sizeof (BookHeader)) {
+    ::close (fd);
+    return false;
+  }
+  void* ptr = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close (fd);
+  if (ptr == MAP_FAILED) return false;
+
+  data      = (const char*) ptr;
+  data_size = st.st_size;
+
+  const BookHeader* header = (const BookHeader*) data;
+  if (memcmp (header->magic, book_file_magic, sizeof (book_file_magic)) != 0 ||
+      data_size != sizeof (BookHeader) + uint64 (header->entry_cnt) * sizeof (BookEntry)) {
+    close ();
+    return false;
+  }
+  entries   = (const BookEntry*) (data + sizeof (BookHeader));
+  entry_cnt = header->entry_cnt;
+  book_komi = header->komi;
+  return true;
+#endif
+}
+
+void OpeningBook::close () {
+#ifndef _MSC_VER
+  if (data != NULL) munmap ((void*) data, data_size);
+#endif
+  data      = NULL;
+  data_size = 0;
+  entries   = NULL;
+  entry_cnt = 0;
+}
+
+uint OpeningBook::size () const {
+  return entry_cnt;
+}
+
+float OpeningBook::komi () const {
+  return book_komi;
+}
+
+uint64 OpeningBook::key (const Board* board, Player pl) {
+  return board->hash ().hash ^ (pl == Player::white () ? white_to_move_key : 0);
+}
+
+bool OpeningBook::probe (const Board* board, Player pl, BookEntry* entry) const {
+  if (entry_cnt == 0 || board->komi () != book_komi) return false;
+
+  BookEntry wanted;
+  wanted.key = key (board, pl);
+  const BookEntry* found = lower_bound (entries, entries + entry_cnt, wanted, entry_less);
+  if (found == entries + entry_cnt || found->key != wanted.key) return false;
+
+  *entry = *found;
+  return true;
+}
+
+bool OpeningBook::write (const string& file_name, vector <BookEntry> entries, float komi) {
+  sort (entries.begin (), entries.end (), entry_less);
+
+  FILE* out = fopen (file_name.c_str (), "wb");
+  if (out == NULL) return false;
+
+  BookHeader header;
+  memcpy (header.magic, book_file_magic, sizeof (book_file_magic));
+  header.entry_cnt = entries.size ();
+  header.komi      = komi;
+
+  fwrite (&header, sizeof (header), 1, out);
+  if (!entries.empty ())
+    fwrite (&entries [0], sizeof (BookEntry), entries.size (), out);
+  return fclose (out) == 0;
+}
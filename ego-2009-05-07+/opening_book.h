@@ -0,0 +1,52 @@
+#ifndef _OPENING_BOOK_H_
+#define _OPENING_BOOK_H_
+
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "board.h"
+
+// Book of best moves from deep offline searches (--build-book). The
+// file is a header and entries sorted by key, mapped read-only and
+// probed by binary search.
+
+struct BookEntry {
+  uint64  key;      // OpeningBook::key
+  uint32_t vertex;  // Vertex::get_idx
+  uint32_t visits;  // of the best move
+  float   mean;     // of the best move, for the player to move (-1 .. 1)
+  uint32_t unused;
+};
+
+class OpeningBook {
+public:
+  OpeningBook ();
+  ~OpeningBook ();
+
+  bool open (const string& file_name);
+  void close ();
+
+  uint  size () const;
+  float komi () const;
+
+  // stones by Board::hash, plus the player to move
+  static uint64 key (const Board* board, Player pl);
+
+  bool probe (const Board* board, Player pl, BookEntry* entry) const;
+
+  // sorts entries by key
+  static bool write (const string& file_name, vector <BookEntry> entries, float komi);
+
+private:
+  const char*       data;
+  uint64            data_size;
+  const BookEntry*  entries;
+  uint              entry_cnt;
+  float             book_komi;
+};
+
+// set by --book, Uct::genmove plays from it while it can
+extern OpeningBook* opening_book;
+
+#endif
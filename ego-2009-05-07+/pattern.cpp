@@ -0,0 +1,201 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "pattern.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "testing.h"
+
+PatternTable* playout_patterns = NULL;
+
+namespace Pattern {
+
+  uint pattern3x3 (const Board* board, Vertex v, Player pl) {
+    uint pattern = 0;
+    uint own     = pl.get_idx ();
+    vertex_for_each_8_nbr (v, nbr, {
+      uint color = board->color_at [nbr].get_idx ();
+      if (color < Color::empty_idx) color ^= own; // own 0, opponent 1
+      pattern = (pattern << 2) | color;
+    });
+    return pattern;
+  }
+
+  // cell (row, col), both in -1 .. 1, of the neighbour at position ii
+  // of pattern3x3; position 0 is in the two highest bits
+  static const int cell_row [8] = { -1, -1, -1,  0, 0,  1, 1, 1 };
+  static const int cell_col [8] = { -1,  0,  1, -1, 1, -1, 0, 1 };
+
+  static uint cell_index (int row, int col) {
+    rep (ii, 8) if (cell_row [ii] == row && cell_col [ii] == col) return ii;
+    assert (false);
+    return 0;
+  }
+
+  static uint transform (uint pattern, uint symmetry) {
+    uint ret = 0;
+    rep (ii, 8) {
+      int row = cell_row [ii];
+      int col = cell_col [ii];
+      if (symmetry & 1) { int tmp = row; row = col; col = tmp; }
+      if (symmetry & 2) row = -row;
+      if (symmetry & 4) col = -col;
+      uint color = (pattern >> (2 * (7 - ii))) & 3;
+      ret |= color << (2 * (7 - cell_index (row, col)));
+    }
+    return ret;
+  }
+
+  // filled before main, so lookups need no locking
+  static class CanonicalTable {
+  public:
+    uint16_t canonical [pattern_cnt];
+
+    CanonicalTable () {
+      rep (pattern, pattern_cnt) {
+        uint best = pattern;
+        reps (symmetry, 1, 8) {
+          uint p = transform (pattern, symmetry);
+          if (p < best) best = p;
+        }
+        canonical [pattern] = best;
+      }
+    }
+  } canonical_table;
+
+  uint canonical (uint pattern) {
+    return canonical_table.canonical [pattern];
+  }
+
+  uint local (const Board* board, Vertex v) {
+    if (board->move_no < 1) return 0;
+    Move   last_move = board->move_history [board->move_no - 1];
+    Vertex last = last_move.get_vertex ();
+    if (last == Vertex::pass ()) return 0;
+
+    if (v == last.N ()  || v == last.E ()  || v == last.W ()  || v == last.S ())  return 1;
+    if (v == last.NW () || v == last.NE () || v == last.SW () || v == last.SE ()) return 2;
+    if (v == last.NN () || v == last.EE () || v == last.WW () || v == last.SS ()) return 3;
+    return 0;
+  }
+
+  RecentAtari::RecentAtari (Board* board, Player pl) {
+    Vertex blacks [10], whites [10];
+    uint   blackc, whitec;
+    board->find_recent_atari (blacks, whites, blackc, whitec, 10);
+
+    bool black = pl == Player::black ();
+    own_cnt = black ? blackc : whitec;
+    opp_cnt = black ? whitec : blackc;
+    rep (ii, own_cnt) own [ii] = black ? blacks [ii] : whites [ii];
+    rep (ii, opp_cnt) opp [ii] = black ? whites [ii] : blacks [ii];
+  }
+
+  uint RecentAtari::atari (Vertex v) const {
+    rep (ii, opp_cnt) if (opp [ii] == v) return 2;
+    rep (ii, own_cnt) if (own [ii] == v) return 1;
+    return 0;
+  }
+}
+
+// class PatternTable
+
+static const char pattern_file_magic [8] = { 'E', 'G', 'O', 'P', 'A', 'T', '1', '\n' };
+
+PatternTable::PatternTable () {
+  rep (ii, Pattern::pattern_cnt) pattern_gamma [ii] = 1.0;
+  rep (ii, Pattern::local_cnt)   local_gamma [ii] = 1.0;
+  rep (ii, Pattern::atari_cnt)   atari_gamma [ii] = 1.0;
+  far_strength = 1.0;
+}
+
+// magic, far_strength, local and atari gammas, count of learned
+// canonical patterns, then (uint16 pattern, float gamma) for each
+
+bool PatternTable::save (const string& file_name) const {
+  FILE* out = fopen (file_name.c_str (), "wb");
+  if (out == NULL) return false;
+
+  fwrite (pattern_file_magic, 1, sizeof (pattern_file_magic), out);
+  fwrite (&far_strength, sizeof (float), 1, out);
+  fwrite (local_gamma, sizeof (float), Pattern::local_cnt, out);
+  fwrite (atari_gamma, sizeof (float), Pattern::atari_cnt, out);
+
+  uint32_t learned_cnt = 0;
+  rep (ii, Pattern::pattern_cnt)
+    if (Pattern::canonical (ii) == ii && pattern_gamma [ii] != 1.0) learned_cnt++;
+  fwrite (&learned_cnt, sizeof (learned_cnt), 1, out);
+
+  rep (ii, Pattern::pattern_cnt) {
+    if (Pattern::canonical (ii) != ii || pattern_gamma [ii] == 1.0) continue;
+    uint16_t pattern = ii;
+    fwrite (&pattern, sizeof (pattern), 1, out);
+    fwrite (&pattern_gamma [ii], sizeof (float), 1, out);
+  }
+
+  return fclose (out) == 0;
+}
+
+bool PatternTable::load (const string& file_name) {
+  FILE* in = fopen (file_name.c_str (), "rb");
+  if (in == NULL) return false;
+
+  // nothing is changed before the whole file is read
+  char     magic [sizeof (pattern_file_magic)];
+  float    new_far_strength;
+  float    new_local_gamma [Pattern::local_cnt];
+  float    new_atari_gamma [Pattern::atari_cnt];
+  uint32_t learned_cnt;
+  bool ok =
+    fread (magic, 1, sizeof (magic), in) == sizeof (magic) &&
+    memcmp (magic, pattern_file_magic, sizeof (magic)) == 0 &&
+    fread (&new_far_strength, sizeof (float), 1, in) == 1 &&
+    fread (new_local_gamma, sizeof (float), Pattern::local_cnt, in) == Pattern::local_cnt &&
+    fread (new_atari_gamma, sizeof (float), Pattern::atari_cnt, in) == Pattern::atari_cnt &&
+    fread (&learned_cnt, sizeof (learned_cnt), 1, in) == 1;
+
+  vector <float> canonical_gamma (Pattern::pattern_cnt, 1.0);
+
+  rep (ii, ok ? learned_cnt : 0) {
+    uint16_t pattern;
+    float    gamma;
+    if (fread (&pattern, sizeof (pattern), 1, in) != 1 ||
+        fread (&gamma, sizeof (gamma), 1, in) != 1) {
+      ok = false;
+      break;
+    }
+    canonical_gamma [pattern] = gamma;
+  }
+  fclose (in);
+
+  if (!ok) return false;
+  far_strength = new_far_strength;
+  rep (ii, Pattern::local_cnt) local_gamma [ii] = new_local_gamma [ii];
+  rep (ii, Pattern::atari_cnt) atari_gamma [ii] = new_atari_gamma [ii];
+  rep (ii, Pattern::pattern_cnt)
+    pattern_gamma [ii] = canonical_gamma [Pattern::canonical (ii)];
+  return true;
+}
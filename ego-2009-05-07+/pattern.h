@@ -0,0 +1,72 @@
+#ifndef _PATTERN_H_
+#define _PATTERN_H_
+
+#include <string>
+
+#include "utils.h"
+#include "board.h"
+
+// Move features for pattern based playouts, all seen from the player
+// to move:
+//
+//   3x3     colors of the 8 neighbours, 2 bits each (own, opponent,
+//           empty, off board) in the order NW N NE W E SW S SE;
+//           the 8 rotations and reflections share one weight
+//   local   0 - far, 1 - N/E/W/S, 2 - diagonal, 3 - two lines away
+//           from the last move (the neighbourhoods of play_local)
+//   atari   0 - none, 1 - saves an own chain in atari,
+//           2 - takes a liberty of an opponent chain in atari
+//
+// The strength of a move is the product of the weights (gammas) of its
+// features (generalized Bradley-Terry model, see pattern_learning.h).
+
+namespace Pattern {
+  const uint pattern_cnt  = 1 << 16;
+  const uint local_cnt    = 4;
+  const uint atari_cnt    = 3;
+
+  uint pattern3x3 (const Board* board, Vertex v, Player pl);
+  uint canonical  (uint pattern);           // smallest of the 8 symmetries
+  uint local      (const Board* board, Vertex v);
+
+  // ataris near the last moves (Board::find_recent_atari), for atari ()
+  // and for the atari moves of the playouts
+  class RecentAtari {
+  public:
+    RecentAtari (Board* board, Player pl);
+    uint atari (Vertex v) const;
+
+    Vertex own [10];   // last liberties of chains of pl
+    Vertex opp [10];   // and of the opponent
+    uint   own_cnt;
+    uint   opp_cnt;
+  };
+}
+
+// Gammas of all features. Saved sparsely: only 3x3 patterns whose
+// gamma was learned are stored, the rest have gamma 1.
+
+class PatternTable {
+public:
+  float  pattern_gamma [Pattern::pattern_cnt]; // for every raw pattern
+  float  local_gamma   [Pattern::local_cnt];
+  float  atari_gamma   [Pattern::atari_cnt];
+
+  // average strength of a move that is not local (local == 0), the
+  // weight of leaving the choice to uniformly random moves
+  float  far_strength;
+
+  PatternTable ();
+
+  bool load (const string& file_name);
+  bool save (const string& file_name) const;
+
+  float strength (uint pattern, uint local, uint atari) const {
+    return pattern_gamma [pattern] * local_gamma [local] * atari_gamma [atari];
+  }
+};
+
+// set by --patterns, ExtPolicy then chooses local moves by their strength
+extern PatternTable* playout_patterns;
+
+#endif
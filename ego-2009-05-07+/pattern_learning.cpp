@@ -0,0 +1,270 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "pattern_learning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "sgf_scanner.h"
+
+namespace PatternLearning {
+
+  // candidate: dense pattern id | local << 24 | atari << 28
+  static const uint local_shift = 24;
+  static const uint atari_shift = 28;
+
+  class TrainingSet {
+  public:
+    vector <uint>    candidates;
+    vector <uint>    begin;         // of each position in candidates
+    vector <uint>    winner;        // index in candidates
+
+    vector <uint>    pattern_of_id; // canonical pattern
+    vector <int>     id_of_pattern;
+    vector <uint>    pattern_seen;  // as a candidate
+
+    TrainingSet () : id_of_pattern (Pattern::pattern_cnt, -1) { }
+
+    uint pattern_id (uint pattern) {
+      if (id_of_pattern [pattern] < 0) {
+        id_of_pattern [pattern] = pattern_of_id.size ();
+        pattern_of_id.push_back (pattern);
+        pattern_seen.push_back (0);
+      }
+      return id_of_pattern [pattern];
+    }
+
+    // false if the played move is not pseudo legal
+    bool add_position (Board* board, Vertex played) {
+      Player pl = board->act_player ();
+      if (played == Vertex::pass () || !played.is_on_board ()) return false;
+      if (!board->is_pseudo_legal (pl, played)) return false;
+
+      Pattern::RecentAtari recent_atari (board, pl);
+      uint first = candidates.size ();
+      int  win   = -1;
+
+      empty_v_for_each (board, v, {
+        if (!board->is_pseudo_legal (pl, v)) continue;
+        if (v == played) win = candidates.size () - first;
+        uint id = pattern_id (Pattern::canonical (Pattern::pattern3x3 (board, v, pl)));
+        pattern_seen [id]++;
+        candidates.push_back (id |
+                              Pattern::local (board, v) << local_shift |
+                              recent_atari.atari (v) << atari_shift);
+      });
+
+      if (win < 0) {
+        candidates.resize (first);
+        return false;
+      }
+      begin.push_back (first);
+      winner.push_back (first + win);
+      return true;
+    }
+
+    uint position_cnt () const { return begin.size (); }
+
+    uint end (uint pos) const {
+      return pos + 1 < begin.size () ? begin [pos + 1] : candidates.size ();
+    }
+  };
+
+  class Fit {
+  public:
+    // all features in one vector: patterns, then local, then atari
+    vector <double> gamma;
+    vector <double> wins;
+    uint            local_base;
+    uint            atari_base;
+
+    Fit (uint pattern_id_cnt) {
+      local_base = pattern_id_cnt;
+      atari_base = local_base + Pattern::local_cnt;
+      gamma.assign (atari_base + Pattern::atari_cnt, 1.0);
+      wins.assign (gamma.size (), 0.0);
+    }
+
+    uint feature (uint candidate, uint group) const {
+      if (group == 0) return candidate & ((1 << local_shift) - 1);
+      if (group == 1) return local_base + ((candidate >> local_shift) & 15);
+      return atari_base + (candidate >> atari_shift);
+    }
+
+    double strength (uint candidate) const {
+      return gamma [feature (candidate, 0)] *
+             gamma [feature (candidate, 1)] *
+             gamma [feature (candidate, 2)];
+    }
+
+    void count_wins (const TrainingSet& set) {
+      rep (pos, set.position_cnt ())
+        rep (group, 3) wins [feature (set.candidates [set.winner [pos]], group)] += 1.0;
+    }
+
+    // one MM step for the features of group, returns log-likelihood
+    // before the step
+    double update (const TrainingSet& set, uint group) {
+      vector <double> denominator (gamma.size (), 0.0);
+      double log_likelihood = 0.0;
+
+      rep (pos, set.position_cnt ()) {
+        double total = 0.0;
+        reps (ii, set.begin [pos], set.end (pos)) total += strength (set.candidates [ii]);
+        log_likelihood += log (strength (set.candidates [set.winner [pos]]) / total);
+
+        reps (ii, set.begin [pos], set.end (pos)) {
+          uint c = set.candidates [ii];
+          uint f = feature (c, group);
+          denominator [f] += strength (c) / gamma [f] / total;
+        }
+      }
+
+      uint first = group == 0 ? 0 : group == 1 ? local_base : atari_base;
+      uint last  = group == 0 ? local_base : group == 1 ? atari_base : gamma.size ();
+      reps (f, first, last) {
+        // prior: one virtual win and one loss against a gamma 1 opponent
+        gamma [f] = (wins [f] + 1.0) / (denominator [f] + 2.0 / (gamma [f] + 1.0));
+      }
+      return log_likelihood;
+    }
+  };
+
+  static bool stronger (pair <double, uint> a, pair <double, uint> b) {
+    return a.first > b.first;
+  }
+
+  static string pattern_to_string (uint pattern) {
+    static const char symbol [4] = { 'X', 'O', '.', '#' }; // own, opp, empty, off
+    string s;
+    rep (ii, 8) {
+      if (ii == 4) s += 'x'; // the move
+      s += symbol [(pattern >> (2 * (7 - ii))) & 3];
+      if (ii == 2 || ii == 4) s += '/';
+    }
+    return s;
+  }
+
+  string learn (const vector <string>& sgf_files,
+                PatternTable* table,
+                uint iteration_cnt,
+                uint min_pattern_cnt)
+  {
+    TrainingSet set;
+    ostringstream out;
+    uint game_cnt = 0;
+
+    rep (ff, sgf_files.size ()) {
+      SgfScanner scanner;
+      SgfGame    game;
+      if (!scanner.open (sgf_files [ff])) {
+        out << "cannot open " << sgf_files [ff] << endl;
+        continue;
+      }
+      while (scanner.next_game (&game)) {
+        Board board;
+        if (!game.replay (&board, 0)) continue; // other board size, late setup
+        game_cnt++;
+        rep (mm, game.moves.size ()) {
+          Player pl = game.moves [mm].get_player ();
+          Vertex v  = game.moves [mm].get_vertex ();
+          if (pl == board.act_player ()) set.add_position (&board, v);
+          if (v != Vertex::pass () && !v.is_on_board ()) break;
+          if (!board.is_pseudo_legal (pl, v)) break;
+          board.play_legal (pl, v);
+          if (board.last_move_status != Board::play_ok) break;
+        }
+      }
+    }
+
+    out << game_cnt << " games, " << set.position_cnt () << " positions, "
+        << set.candidates.size () << " candidate moves, "
+        << set.pattern_of_id.size () << " patterns" << endl;
+    if (set.position_cnt () == 0) return out.str ();
+
+    Fit fit (set.pattern_of_id.size ());
+    fit.count_wins (set);
+
+    rep (it, iteration_cnt) {
+      double log_likelihood = 0.0;
+      rep (group, 3) log_likelihood = fit.update (set, group);
+      char buf [100];
+      sprintf (buf, "iteration %u: mean log-likelihood %.4f",
+               it + 1, log_likelihood / set.position_cnt ());
+      out << buf << endl;
+    }
+
+    // into the table, rare patterns stay at 1
+    *table = PatternTable ();
+    vector <double> canonical_gamma (Pattern::pattern_cnt, 1.0);
+    rep (id, set.pattern_of_id.size ()) {
+      if (set.pattern_seen [id] >= min_pattern_cnt)
+        canonical_gamma [set.pattern_of_id [id]] = fit.gamma [id];
+    }
+    rep (pattern, Pattern::pattern_cnt)
+      table->pattern_gamma [pattern] = canonical_gamma [Pattern::canonical (pattern)];
+    rep (ii, Pattern::local_cnt) table->local_gamma [ii] = fit.gamma [fit.local_base + ii];
+    rep (ii, Pattern::atari_cnt) table->atari_gamma [ii] = fit.gamma [fit.atari_base + ii];
+
+    double far_sum = 0.0;
+    double far_cnt = 0.0;
+    rep (ii, set.candidates.size ()) {
+      uint c = set.candidates [ii];
+      if (fit.feature (c, 1) != fit.local_base) continue;
+      far_sum += table->strength (set.pattern_of_id [fit.feature (c, 0)], 0, c >> atari_shift);
+      far_cnt += 1.0;
+    }
+    table->far_strength = far_cnt > 0.0 ? far_sum / far_cnt : 1.0;
+
+    // summary
+    char buf [100];
+    rep (ii, Pattern::local_cnt) {
+      sprintf (buf, "local %u gamma %.3f", ii, table->local_gamma [ii]);
+      out << buf << endl;
+    }
+    rep (ii, Pattern::atari_cnt) {
+      sprintf (buf, "atari %u gamma %.3f", ii, table->atari_gamma [ii]);
+      out << buf << endl;
+    }
+    sprintf (buf, "far move strength %.3f", table->far_strength);
+    out << buf << endl;
+
+    vector <pair <double, uint> > ranked;
+    rep (id, set.pattern_of_id.size ())
+      if (set.pattern_seen [id] >= min_pattern_cnt)
+        ranked.push_back (make_pair (fit.gamma [id], id));
+    uint top_cnt = min (uint (ranked.size ()), uint (10));
+    partial_sort (ranked.begin (), ranked.begin () + top_cnt, ranked.end (), stronger);
+    rep (ii, top_cnt) {
+      uint id = ranked [ii].second;
+      sprintf (buf, "pattern %s gamma %.3f seen %u",
+               pattern_to_string (set.pattern_of_id [id]).c_str (),
+               ranked [ii].first, set.pattern_seen [id]);
+      out << buf << endl;
+    }
+
+    return out.str ();
+  }
+}
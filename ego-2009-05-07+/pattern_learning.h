@@ -0,0 +1,23 @@
+#ifndef _PATTERN_LEARNING_H_
+#define _PATTERN_LEARNING_H_
+
+#include <string>
+#include <vector>
+
+#include "pattern.h"
+
+// Fits the gammas of a PatternTable to the moves of SGF games with the
+// minorization-maximization algorithm for generalized Bradley-Terry
+// models (R. Coulom, "Computing Elo Ratings of Move Patterns in the Game
+// of Go", 2007). Every position is a competition between all pseudo
+// legal moves, won by the move that was played.
+
+namespace PatternLearning {
+  // progress and a summary of the strongest patterns
+  string learn (const vector <string>& sgf_files,
+                PatternTable* table,
+                uint iteration_cnt = 20,
+                uint min_pattern_cnt = 3);  // rarer patterns keep gamma 1
+}
+
+#endif
@@ -0,0 +1,129 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const char* PerfCounters::event_name [event_cnt] = {
+  "instructions",
+  "cycles",
+  "branch_misses",
+  "l1d_misses",
+  "llc_misses"
+};
+
+#ifdef __linux__
+
+static int open_event (uint type, uint64 config) {
+  perf_event_attr attr;
+  memset (&attr, 0, sizeof (attr));
+  attr.size           = sizeof (attr);
+  attr.type           = type;
+  attr.config         = config;
+  attr.disabled       = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  // every counter on its own, so one missing event does not take the rest down
+  return syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters () {
+  uint64 l1d_read_miss =
+    PERF_COUNT_HW_CACHE_L1D |
+    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+  fd [instructions]  = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  fd [cycles]        = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  fd [branch_misses] = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+  fd [l1d_misses]    = open_event (PERF_TYPE_HW_CACHE, l1d_read_miss);
+  fd [llc_misses]    = open_event (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+
+  rep (ii, event_cnt) count [ii] = 0.0;
+}
+
+PerfCounters::~PerfCounters () {
+  rep (ii, event_cnt) if (fd [ii] >= 0) close (fd [ii]);
+}
+
+void PerfCounters::start () {
+  rep (ii, event_cnt) {
+    count [ii] = 0.0;
+    if (fd [ii] < 0) continue;
+    ioctl (fd [ii], PERF_EVENT_IOC_RESET, 0);
+    ioctl (fd [ii], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+void PerfCounters::stop () {
+  rep (ii, event_cnt) {
+    if (fd [ii] < 0) continue;
+    ioctl (fd [ii], PERF_EVENT_IOC_DISABLE, 0);
+
+    uint64 data [3]; // value, time enabled, time running
+    if (read (fd [ii], data, sizeof (data)) != sizeof (data) || data [2] == 0) {
+      count [ii] = 0.0;
+      continue;
+    }
+    count [ii] = double (data [0]) * double (data [1]) / double (data [2]);
+  }
+}
+
+#else
+
+PerfCounters::PerfCounters () {
+  rep (ii, event_cnt) {
+    fd [ii]    = -1;
+    count [ii] = 0.0;
+  }
+}
+
+PerfCounters::~PerfCounters () { }
+
+void PerfCounters::start () { }
+
+void PerfCounters::stop () { }
+
+#endif
+
+bool PerfCounters::is_available (Event e) {
+  return fd [e] >= 0;
+}
+
+bool PerfCounters::any_available () {
+  rep (ii, event_cnt) if (fd [ii] >= 0) return true;
+  return false;
+}
+
+double PerfCounters::value (Event e) {
+  return count [e];
+}
@@ -0,0 +1,40 @@
+#ifndef _PERF_COUNTERS_H_
+#define _PERF_COUNTERS_H_
+
+#include "utils.h"
+
+// Hardware event counters of the calling thread, user space only
+// (Linux perf_event_open). Events which the kernel or the cpu does not
+// provide (virtual machines, perf_event_paranoid > 2, other systems)
+// are just unavailable, the rest still count.
+
+class PerfCounters {
+public:
+  enum Event {
+    instructions,
+    cycles,
+    branch_misses,
+    l1d_misses,
+    llc_misses,
+    event_cnt
+  };
+
+  static const char* event_name [event_cnt];
+
+  PerfCounters ();
+  ~PerfCounters ();
+
+  bool   is_available (Event e);
+  bool   any_available ();
+
+  void   start ();           // resets and enables all counters
+  void   stop ();
+
+  double value (Event e);    // scaled when the kernel multiplexed counters
+
+private:
+  int     fd    [event_cnt];
+  double  count [event_cnt];
+};
+
+#endif
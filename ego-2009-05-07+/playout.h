@@ -3,6 +3,8 @@
 
 #include "utils.h"
 #include "board.h"
+#include "search_profile.h"
+#include "pattern.h"
 
 #include <cmath>
 
@@ -61,18 +63,38 @@ public:
   flatten all_inline
   void play_move (Board* board) {
 #ifdef USE_BEGINING_IN_PLAYOUT
-		if (play_begin(board)) return; // gramy rozpoczecie !!!
+    profile_start (profile_policy_begin);
+		bool begin_played = play_begin(board);
+    profile_stop (profile_policy_begin);
+		if (begin_played) { profile_hit (profile_policy_begin); return; } // gramy rozpoczecie !!!
 #endif
 #ifdef USE_ATARI_IN_PLAYOUT
-		if (play_atari(board)) return; // gramy atari !!!
+    profile_start (profile_policy_atari);
+    // play_pattern uses the same ataris
+    Pattern::RecentAtari recent_atari (board, board->act_player ());
+		bool atari_played = play_atari(board, recent_atari);
+    profile_stop (profile_policy_atari);
+		if (atari_played) { profile_hit (profile_policy_atari); return; } // gramy atari !!!
 #endif 
 #ifdef USE_LOCALITY_IN_PLAYOUT
-		if (play_local(board)) return; // gramy lokalnie !!!
+    profile_start (profile_policy_local);
+    bool local_played;
+    if (playout_patterns != NULL) {
+#ifndef USE_ATARI_IN_PLAYOUT
+      Pattern::RecentAtari recent_atari (board, board->act_player ());
+#endif
+      local_played = play_pattern(board, recent_atari);
+    } else {
+      local_played = play_local(board);
+    }
+    profile_stop (profile_policy_local);
+		if (local_played) { profile_hit (profile_policy_local); return; } // gramy lokalnie !!!
 #endif
 
 		// Jakis inny losowy ruch - byc moze jeden z wczesniej 
 		// odrzuconych przez play_atari() lub play_local().
     
+    profile_start (profile_policy_random);
 		uint ii_start = random.rand_int (board->empty_v_cnt); 
     uint ii = ii_start;
     Player act_player = board->act_player ();
@@ -83,12 +105,15 @@ public:
       if (!board->is_eyelike (act_player, v) &&
           board->is_pseudo_legal (act_player, v)) { 
         board->play_legal(act_player, v);
+        profile_stop (profile_policy_random);
+        profile_hit (profile_policy_random);
         return;
       }
       ii += 1;
       ii &= ~(-(ii == board->empty_v_cnt)); // if (ii==board->empty_v_cnt) ii=0;
       if (ii == ii_start) {
         board->play_legal(act_player, Vertex::pass());
+        profile_stop (profile_policy_random);
         return;
       }
     }
@@ -143,16 +168,13 @@ private:
   }
 
   flatten all_inline
-  bool play_atari (Board* board) {
+  bool play_atari (Board* board, const Pattern::RecentAtari& recent_atari) {
     Player act_player  = board->act_player();
-		Vertex blacks[10], whites[10], *vs;
-		uint blackc, whitec, vc;
+		const Vertex* vs;
+		uint vc;
 
-		// Wyszukujemy ostatnie zagrania na atari
-		board->find_recent_atari(blacks, whites, blackc, whitec, 10);
-
-		vs = act_player == Player::black() ? blacks:whites;
-		vc = act_player == Player::black() ? blackc:whitec;
+		vs = recent_atari.own;
+		vc = recent_atari.own_cnt;
 
 		// Uciekamy z atari
 		if (vc > 0 && random.rand_int(4) == 0) {
@@ -171,8 +193,8 @@ private:
 			} while (start != i);
 		}
 
-		vs = act_player == Player::white() ? blacks:whites;
-		vc = act_player == Player::white() ? blackc:whitec;
+		vs = recent_atari.opp;
+		vc = recent_atari.opp_cnt;
 
 		// Dajemy atari
 		if (vc > 0 && random.rand_int(4) != 0) {
@@ -192,7 +214,8 @@ private:
     if (board->move_no < 1) return false;
 	
 		/**** local-p7 ****/
-		uint r = random.rand_int(7);
+		uint r, i_start;
+		random.rand_int2(7, 4, &r, &i_start);
     Vertex center1 = board->move_history[board->move_no-1].get_vertex();
 		Vertex local[4];
 		 
@@ -222,7 +245,7 @@ private:
 
     Player act_player = board->act_player ();
 
-    uint i_start = random.rand_int(4), i = i_start;
+    uint i = i_start;
     do {
       if (local[i].is_on_board() &&
           board->color_at[local[i]] == Color::empty() &&
@@ -238,6 +261,50 @@ private:
     return false;
   }
 
+  // Zamiast play_local, gdy wczytano wzorce (--patterns): ruch lokalny
+  // losowany proporcjonalnie do sily (gamma) wzorca, reszta sily
+  // zostaje dla ruchow losowych z calej planszy.
+  flatten all_inline
+  bool play_pattern (Board* board, const Pattern::RecentAtari& recent_atari) {
+    if (board->move_no < 1) return false;
+    Vertex center1 = board->move_history[board->move_no-1].get_vertex();
+    if (center1 == Vertex::pass()) return false;
+
+    Player act_player = board->act_player ();
+    Vertex local[12] = {
+      center1.N(),  center1.E(),  center1.W(),  center1.S(),   // local 1
+      center1.NW(), center1.NE(), center1.SW(), center1.SE(),  // local 2
+      center1.NN(), center1.EE(), center1.WW(), center1.SS()   // local 3
+    };
+    float  strength[12];
+    float  total = 0.0;
+    uint   cnt = 0;
+
+    rep (ii, 12) {
+      Vertex v = local[ii];
+      if (!v.is_on_board() ||
+          board->color_at[v] != Color::empty() ||
+          board->is_eyelike(act_player, v) ||
+          !board->is_pseudo_legal(act_player, v)) continue;
+      strength[cnt] = playout_patterns->strength (
+        Pattern::pattern3x3 (board, v, act_player), 1 + ii / 4, recent_atari.atari (v));
+      total += strength[cnt];
+      local[cnt++] = v;
+    }
+    if (cnt == 0) return false;
+
+    float far_total = playout_patterns->far_strength * (board->empty_v_cnt - cnt);
+    float r = random.rand_int () * (1.0 / 4294967296.0) * (total + far_total);
+    rep (ii, cnt) {
+      r -= strength[ii];
+      if (r < 0.0) {
+        board->play_legal(act_player, local[ii]);
+        return true;
+      }
+    }
+    return false;
+  }
+
 };
 
 
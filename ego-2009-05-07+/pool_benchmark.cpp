@@ -0,0 +1,174 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "pool_benchmark.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "fast_pool.h"
+#include "fast_random.h"
+
+namespace PoolBenchmark {
+
+  static const uint max_live_cnt = 1024; // per thread
+
+  struct Elt {
+    volatile uint  owner;                // thread id + 1, 0 when free
+    char           padding [60];
+  };
+
+  // FastPool behind one mutex, NULL when exhausted like Magazine
+  class LockedPool {
+  public:
+    LockedPool (FastPool <Elt>& pool_, pthread_mutex_t& mutex_)
+      : pool (pool_), mutex (mutex_) { }
+
+    Elt* malloc () {
+      pthread_mutex_lock (&mutex);
+      Elt* ret = pool.can_malloc (1) ? pool.malloc () : NULL;
+      pthread_mutex_unlock (&mutex);
+      return ret;
+    }
+
+    void free (Elt* elt) {
+      pthread_mutex_lock (&mutex);
+      pool.free (elt);
+      pthread_mutex_unlock (&mutex);
+    }
+
+  private:
+    FastPool <Elt>&   pool;
+    pthread_mutex_t&  mutex;
+  };
+
+  struct Worker {
+    uint              id;
+    uint              op_cnt;
+    bool              locked;
+    SharedPool <Elt>* shared;
+    FastPool <Elt>*   central;
+    pthread_mutex_t*  mutex;
+
+    uint64            null_cnt;
+    uint64            error_cnt;
+  };
+
+  template <class alloc_t>
+  static void work (Worker* w, alloc_t& alloc) {
+    FastRandom   random = global_random.stream (w->id + 1);
+    vector <Elt*> live;
+    live.reserve (max_live_cnt);
+    uint owner = w->id + 1;
+
+    rep (op, w->op_cnt) {
+      if (live.size () == max_live_cnt || (!live.empty () && random.rand_int (2) == 0)) {
+        uint ii  = random.rand_int (live.size ());
+        Elt* elt = live [ii];
+        live [ii] = live.back ();
+        live.pop_back ();
+        if (!__sync_bool_compare_and_swap (&elt->owner, owner, 0)) w->error_cnt++;
+        alloc.free (elt);
+      } else {
+        Elt* elt = alloc.malloc ();
+        if (elt == NULL) {
+          w->null_cnt++;
+          continue;
+        }
+        if (!__sync_bool_compare_and_swap (&elt->owner, 0, owner)) w->error_cnt++;
+        live.push_back (elt);
+      }
+    }
+
+    rep (ii, live.size ()) {
+      if (!__sync_bool_compare_and_swap (&live [ii]->owner, owner, 0)) w->error_cnt++;
+      alloc.free (live [ii]);
+    }
+  }
+
+  static void* worker_main (void* worker_ptr) {
+    Worker* w = (Worker*) worker_ptr;
+    if (w->locked) {
+      LockedPool alloc (*w->central, *w->mutex);
+      work (w, alloc);
+    } else {
+      SharedPool <Elt>::Magazine alloc (*w->shared);
+      work (w, alloc);
+    }
+    return NULL;
+  }
+
+  static string run_one (uint thread_cnt, uint op_cnt, bool locked) {
+    // a quarter short of what all threads may hold at once
+    uint pool_size = thread_cnt * max_live_cnt * 3 / 4;
+
+    SharedPool <Elt>  shared (pool_size);
+    FastPool <Elt>    central (pool_size);
+    pthread_mutex_t   mutex;
+    pthread_mutex_init (&mutex, NULL);
+
+    vector <Worker>    workers (thread_cnt);
+    vector <pthread_t> threads;
+    double begin = wall_clock_time ();
+    rep (ii, thread_cnt) {
+      Worker& w = workers [ii];
+      w.id        = ii;
+      w.op_cnt    = op_cnt;
+      w.locked    = locked;
+      w.shared    = &shared;
+      w.central   = &central;
+      w.mutex     = &mutex;
+      w.null_cnt  = 0;
+      w.error_cnt = 0;
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, worker_main, &w) != 0) break;
+      threads.push_back (thread);
+    }
+    rep (ii, threads.size ()) pthread_join (threads [ii], NULL);
+    double seconds = wall_clock_time () - begin;
+    pthread_mutex_destroy (&mutex);
+
+    uint64 null_cnt = 0, error_cnt = 0;
+    rep (ii, threads.size ()) {
+      null_cnt  += workers [ii].null_cnt;
+      error_cnt += workers [ii].error_cnt;
+    }
+    double ops = double (op_cnt) * threads.size ();
+
+    char buf [200];
+    sprintf (buf, "%-16s %.0f %.1f %llu %llu\n",
+             locked ? "locked_fast_pool" : "shared_pool", ops,
+             ops > 0 ? seconds * 1e9 / ops : 0.0,
+             (unsigned long long) null_cnt, (unsigned long long) error_cnt);
+    return buf;
+  }
+
+  string run (uint thread_cnt, uint op_cnt) {
+    if (thread_cnt == 0) thread_cnt = 1;
+    ostringstream out;
+    out << "# " << thread_cnt << " threads, " << op_cnt << " operations each" << endl;
+    out << run_one (thread_cnt, op_cnt, false);
+    out << run_one (thread_cnt, op_cnt, true);
+    return out.str ();
+  }
+}
@@ -0,0 +1,22 @@
+#ifndef _POOL_BENCHMARK_H_
+#define _POOL_BENCHMARK_H_
+
+#include <string>
+
+#include "utils.h"
+
+// Threads doing random malloc / free on one small SharedPool, each
+// keeping up to a fixed number of live elements, so together they
+// exhaust the pool now and then. Every element records the thread that
+// holds it; an element handed out to a second thread is counted as an
+// error. The same work on a FastPool behind one mutex is the baseline.
+//
+//   <allocator> <operations> <ns per operation> <null mallocs> <errors>
+//
+// with the wall time divided by the operations of all threads.
+
+namespace PoolBenchmark {
+  string run (uint thread_cnt, uint op_cnt);
+}
+
+#endif
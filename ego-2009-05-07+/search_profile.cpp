@@ -0,0 +1,140 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cstdio>
+#include <pthread.h>
+
+#include "search_profile.h"
+#include "testing.h"
+
+const char* SearchProfile::phase_name [profile_phase_cnt] = {
+  "search",
+  "board_load",
+  "widen",
+  "find_uct_child",
+  "tree_move",
+  "expand",
+  "playout",
+  "score",
+  "update",
+  "policy_begin",
+  "policy_atari",
+  "policy_local",
+  "policy_random"
+};
+
+SearchProfile::SearchProfile () {
+  reset ();
+}
+
+void SearchProfile::reset () {
+  rep (ii, profile_phase_cnt) {
+    timer [ii].reset ();
+    hits [ii] = 0;
+  }
+}
+
+static vector <SearchProfile*>  all_profiles;
+static pthread_mutex_t          all_profiles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+SearchProfile& thread_profile () {
+  static thread_local_pod SearchProfile* profile = NULL;
+  if (profile == NULL) {
+    profile = new SearchProfile;
+    pthread_mutex_lock (&all_profiles_mutex);
+    all_profiles.push_back (profile);
+    pthread_mutex_unlock (&all_profiles_mutex);
+  }
+  return *profile;
+}
+
+namespace Profile {
+
+  void reset_all () {
+    pthread_mutex_lock (&all_profiles_mutex);
+    rep (ii, all_profiles.size ()) all_profiles [ii]->reset ();
+    pthread_mutex_unlock (&all_profiles_mutex);
+  }
+
+  // phase, calls, average cycles, total Mcycles, share of search, hits
+  string to_string () {
+    double cnt [profile_phase_cnt];
+    double sum [profile_phase_cnt];
+    uint64 hits [profile_phase_cnt];
+
+    rep (ph, profile_phase_cnt) { cnt [ph] = 0.0; sum [ph] = 0.0; hits [ph] = 0; }
+
+    pthread_mutex_lock (&all_profiles_mutex);
+    rep (ii, all_profiles.size ()) {
+      rep (ph, profile_phase_cnt) {
+        cnt  [ph] += all_profiles [ii]->timer [ph].samples ();
+        sum  [ph] += all_profiles [ii]->timer [ph].total_ticks ();
+        hits [ph] += all_profiles [ii]->hits [ph];
+      }
+    }
+    pthread_mutex_unlock (&all_profiles_mutex);
+
+    ostringstream out;
+    char buf [200];
+    sprintf (buf, "%-16s %12s %10s %12s %7s %12s",
+             "phase", "calls", "avg_cc", "total_Mcc", "search%", "hits");
+    out << buf << endl;
+
+    rep (ph, profile_phase_cnt) {
+      if (cnt [ph] == 0.0) continue;
+      sprintf (buf, "%-16s %12.0f %10.1f %12.2f %6.1f%% %12llu",
+               SearchProfile::phase_name [ph],
+               cnt [ph],
+               sum [ph] / cnt [ph],
+               sum [ph] / 1000000.0,
+               sum [profile_search] > 0.0 ? 100.0 * sum [ph] / sum [profile_search] : 0.0,
+               hits [ph]);
+      out << buf << endl;
+    }
+    return out.str ();
+  }
+
+}
+
+ProfileGtp::ProfileGtp (Gtp& gtp) {
+  gtp.add_gtp_command (this, "profile.show");
+  gtp.add_gtp_command (this, "profile.reset");
+}
+
+GtpResult ProfileGtp::exec_command (const string& command, istream& params) {
+  unused (params);
+#ifndef USE_SEARCH_PROFILE
+  return GtpResult::failure ("profiling not compiled in, use -DUSE_SEARCH_PROFILE");
+#endif
+
+  if (command == "profile.show") {
+    return GtpResult::success ("\n" + Profile::to_string ());
+  }
+
+  if (command == "profile.reset") {
+    Profile::reset_all ();
+    return GtpResult::success ();
+  }
+
+  assert (false);
+}
@@ -0,0 +1,73 @@
+#ifndef _SEARCH_PROFILE_H_
+#define _SEARCH_PROFILE_H_
+
+#include <vector>
+
+#include "utils.h"
+#include "fast_timer.h"
+#include "gtp.h"
+
+// Cycle counters of search phases and playout heuristics, compiled in
+// with -DUSE_SEARCH_PROFILE. Without it profile_start / profile_stop /
+// profile_hit expand to nothing. Every thread counts separately, reports
+// sum all threads. Phases from board_load to update do not overlap, the
+// policy heuristics are parts of playout.
+
+enum ProfilePhase {
+  profile_search,          // whole genmove
+  profile_board_load,
+  profile_widen,           // progressive widening on the way down
+  profile_find_uct_child,
+  profile_tree_move,       // playing the chosen child on the board
+  profile_expand,
+  profile_playout,
+  profile_score,
+  profile_update,
+  profile_policy_begin,    // ExtPolicy heuristics, within playout
+  profile_policy_atari,
+  profile_policy_local,
+  profile_policy_random,
+  profile_phase_cnt
+};
+
+class SearchProfile {
+public:
+  FastTimer  timer [profile_phase_cnt];
+  uint64     hits  [profile_phase_cnt]; // heuristic played a move
+
+  SearchProfile ();
+  void reset ();
+
+  static const char* phase_name [profile_phase_cnt];
+};
+
+SearchProfile& thread_profile ();
+
+namespace Profile {
+  void reset_all ();
+  string to_string ();
+}
+
+#ifdef USE_SEARCH_PROFILE
+
+#define profile_start(phase) thread_profile ().timer [phase].start ()
+#define profile_stop(phase)  thread_profile ().timer [phase].stop ()
+#define profile_hit(phase)   (thread_profile ().hits [phase]++)
+
+#else
+
+#define profile_start(phase)
+#define profile_stop(phase)
+#define profile_hit(phase)
+
+#endif
+
+// profile.show, profile.reset
+
+class ProfileGtp : public GtpCommand {
+public:
+  ProfileGtp (Gtp& gtp);
+  virtual GtpResult exec_command (const string& command, istream& params);
+};
+
+#endif
@@ -0,0 +1,254 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "sgf_scanner.h"
+
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "board.h"
+#include "testing.h"
+
+// class SgfGame
+
+void SgfGame::clear () {
+  board_size = 19;
+  komi       = 0.0;
+  result.clear ();
+  setup.clear ();
+  moves.clear ();
+  late_setup = false;
+}
+
+bool SgfGame::replay (Board* board, uint max_move_cnt) const {
+  if (board_size != ::board_size) return false;
+  if (late_setup) return false;
+
+  board->clear ();
+  board->set_komi (-komi); // as the gtp komi command
+
+  rep (ii, setup.size () + min (uint (moves.size ()), max_move_cnt)) {
+    Move   move = ii < setup.size () ? setup [ii] : moves [ii - setup.size ()];
+    Player pl   = move.get_player ();
+    Vertex v    = move.get_vertex ();
+
+    if (v != Vertex::pass () && !v.is_on_board ()) return false;
+    if (!board->is_pseudo_legal (pl, v)) return false;
+    board->play_legal (pl, v);
+    if (board->last_move_status != Board::play_ok) return false;
+  }
+  return true;
+}
+
+// class SgfScanner
+
+SgfScanner::SgfScanner () : data (NULL), data_size (0), pos (NULL), data_end (NULL) {
+}
+
+SgfScanner::~SgfScanner () {
+  close ();
+}
+
+bool SgfScanner::open (const string& file_name) {
+  close ();
+
+#ifdef _MSC_VER
+  ifstream in (file_name.c_str (), ios::binary);
+  if (!in) return false;
+  in.seekg (0, ios::end);
+  data_size = in.tellg ();
+  in.seekg (0, ios::beg);
+  char* buf = new char [data_size + 1];
+  in.read (buf, data_size);
+  data = buf;
+#else
+  int fd = ::open (file_name.c_str (), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat (fd, &st) != 0) {
+    ::close (fd);
+    return false;
+  }
+  data_size = st.st_size;
+
+  if (data_size > 0) {
+    void* ptr = mmap (NULL, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    if (ptr == MAP_FAILED) {
+      data_size = 0;
+      return false;
+    }
+    madvise (ptr, data_size, MADV_SEQUENTIAL);
+    data = (const char*) ptr;
+  } else {
+    ::close (fd);
+    data = "";
+  }
+#endif
+
+  pos      = data;
+  data_end = data + data_size;
+  return true;
+}
+
+void SgfScanner::close () {
+  if (data == NULL) return;
+#ifdef _MSC_VER
+  delete [] data;
+#else
+  if (data_size > 0) munmap ((void*) data, data_size);
+#endif
+  data      = NULL;
+  data_size = 0;
+  pos       = NULL;
+  data_end  = NULL;
+}
+
+// Vertex::of_sgf_coords of a value, without building a string
+static Vertex sgf_coords_vertex (const char* begin, const char* end) {
+  uint len = end - begin;
+  if (len == 0) return Vertex::pass ();
+  if (len != 2) return Vertex::any ();
+  if (begin [0] == 't' && begin [1] == 't' && board_size <= 19) return Vertex::pass ();
+  Coord col (begin [0] - 'a');
+  Coord row (begin [1] - 'a');
+  if (!row.is_on_board () || !col.is_on_board ()) return Vertex::any ();
+  return Vertex (row, col);
+}
+
+static bool id_is (const char* begin, const char* end, const char* id) {
+  while (begin < end && *begin == *id) {
+    begin++;
+    id++;
+  }
+  return begin == end && *id == '\0';
+}
+
+// pos at '[', moves past the matching ']'
+void SgfScanner::skip_value () {
+  const char* begin;
+  const char* end;
+  read_value (&begin, &end);
+}
+
+bool SgfScanner::read_value (const char** begin, const char** end) {
+  assertc (sgf_ac, *pos == '[');
+  pos++;
+  *begin = pos;
+  while (pos < data_end && *pos != ']') {
+    if (*pos == '\\') pos++; // escaped character
+    pos++;
+  }
+  if (pos >= data_end) return false;
+  *end = pos;
+  pos++;
+  return true;
+}
+
+bool SgfScanner::next_game (SgfGame* game) {
+  game->clear ();
+
+  // start of the next game tree
+  while (pos < data_end && *pos != '(') pos++;
+  if (pos >= data_end) return false;
+
+  int  depth   = 0;
+  bool in_main = true;  // main line is the first child at every branching
+
+  while (pos < data_end) {
+    char c = *pos;
+
+    if (c == '(') {
+      depth++;
+      pos++;
+      continue;
+    }
+
+    if (c == ')') {
+      depth--;
+      pos++;
+      in_main = false;  // the main line never continues after a ')'
+      if (depth == 0) return true;
+      continue;
+    }
+
+    if (c == '[') { // value of a skipped property
+      skip_value ();
+      continue;
+    }
+
+    if (c < 'A' || c > 'Z') {
+      pos++;
+      continue;
+    }
+
+    // property identifier
+    const char* id_begin = pos;
+    while (pos < data_end && *pos >= 'A' && *pos <= 'Z') pos++;
+    const char* id_end = pos;
+
+    bool is_move  = id_is (id_begin, id_end, "B")  || id_is (id_begin, id_end, "W");
+    bool is_setup = id_is (id_begin, id_end, "AB") || id_is (id_begin, id_end, "AW");
+    bool is_clear = id_is (id_begin, id_end, "AE");
+    Player pl     = id_end [-1] == 'B' ? Player::black () : Player::white ();
+
+    while (pos < data_end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) pos++;
+
+    // values
+    while (pos < data_end && *pos == '[') {
+      const char* begin;
+      const char* end;
+      if (!in_main) {
+        skip_value ();
+      } else if (read_value (&begin, &end)) {
+        // a value always ends at ']', which stops atoi and atof
+        if (is_move) {
+          game->moves.push_back (Move (pl, sgf_coords_vertex (begin, end)));
+        } else if (is_setup && game->moves.empty ()) {
+          game->setup.push_back (Move (pl, sgf_coords_vertex (begin, end)));
+        } else if (is_setup || is_clear) {
+          // setup holds only stones placed before the first move
+          game->late_setup = true;
+        } else if (id_is (id_begin, id_end, "SZ")) {
+          game->board_size = atoi (begin);
+        } else if (id_is (id_begin, id_end, "KM")) {
+          game->komi = atof (begin);
+        } else if (id_is (id_begin, id_end, "RE")) {
+          game->result.assign (begin, end);
+        }
+      }
+      while (pos < data_end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) pos++;
+    }
+  }
+
+  return true; // truncated last game
+}
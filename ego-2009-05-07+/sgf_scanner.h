@@ -0,0 +1,60 @@
+#ifndef _SGF_SCANNER_H_
+#define _SGF_SCANNER_H_
+
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "move.h"
+
+class Board;
+
+// One game of a collection: the main line only, no node tree.
+
+class SgfGame {
+public:
+  uint           board_size;   // SZ, 19 if missing
+  float          komi;         // KM
+  string         result;       // RE, e.g. "B+R", "W+2.5", empty if missing
+  vector <Move>  setup;        // AB, AW before the first move
+  vector <Move>  moves;        // B, W of the main line, in order
+  bool           late_setup;   // AB, AW after the first move, or any AE
+
+  void clear ();
+
+  // setup stones and the first max_move_cnt moves, each checked with
+  // is_pseudo_legal and played with play_legal; false on a bad move,
+  // another board size or late_setup
+  bool replay (Board* board, uint max_move_cnt = max_uint) const;
+
+  static const uint max_uint = ~0u;
+};
+
+// Streams the games of an SGF file (one game or a whole collection)
+// straight from a read-only memory mapping. Only SZ, KM, RE, B, W, AB,
+// AW and AE are decoded; other properties and side variations are skipped
+// without copying. SgfGame buffers are reused, so a pass over many games
+// does not allocate per game.
+
+class SgfScanner {
+public:
+  SgfScanner ();
+  ~SgfScanner ();
+
+  bool open (const string& file_name);
+  void close ();
+
+  // false at the end of the file
+  bool next_game (SgfGame* game);
+
+private:
+  void skip_value ();
+  bool read_value (const char** begin, const char** end);
+
+  const char*  data;
+  uint64       data_size;
+  const char*  pos;
+  const char*  data_end;
+};
+
+#endif
@@ -66,5 +66,6 @@ const bool uct_ac             = all_tests;
 const bool tree_ac            = all_tests;
 const bool pool_ac            = all_tests;
 const bool gtp_ac             = all_tests;
+const bool sgf_ac             = all_tests;
 
 #endif
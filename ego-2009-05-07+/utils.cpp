@@ -26,6 +26,7 @@
 #include <windows.h>
 #else 
 #include <sys/resource.h>
+#include <sys/time.h>
 #endif
 
 #include <iostream>
@@ -70,6 +71,16 @@ float process_user_time () {
 
 }
 
+double wall_clock_time () {
+#ifndef WIN32
+  timeval t;
+  gettimeofday (&t, NULL);
+  return double (t.tv_sec) + double (t.tv_usec) / 1000000.0;
+#else
+  return double (GetTickCount ()) / 1000.0;
+#endif
+}
+
 void fatal_error (const char* s) {
   cerr << "Fatal error: " << s << endl;
   assert (false);
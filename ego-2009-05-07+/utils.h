@@ -25,6 +25,8 @@ typedef unsigned long long uint64;
 const float large_float = 1000000000000.0;
 
 float process_user_time ();
+void fatal_error (const char* s);
+double wall_clock_time (); // in seconds
 
 // string/stream opereations
 
@@ -58,12 +60,14 @@ bool string_to(const string &s, T* i) {
 #define no_inline   __declspec(noinline)
 #define flatten
 #define all_inline  __forceinline
+#define thread_local_pod  __declspec(thread)
 
 #else
 
 #define no_inline   __attribute__((noinline))
 #define flatten     __attribute__((flatten))
 #define all_inline  __attribute__((always_inline))
+#define thread_local_pod  __thread // only for POD types, eg. pointers
 
 #endif //_MSC_VER
 
@@ -0,0 +1,111 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// ----------------------------------------------------------------------
+
+// lz-analyze [player] [interval]
+//
+// Open ended uct search on the current board. Every interval centiseconds
+// a line of "info move .. visits .. winrate .. order .. pv .." blocks
+// for the most visited root children is streamed, until the next command
+// arrives. In synchronous mode (gtp files) the search stops after
+// max_playouts. It runs on the genmove engine, so its tree can be saved
+// and a loaded one (uct.tree.load) is continued.
+
+class AnalyzeGtp : public GtpCommand {
+public:
+  Gtp&              gtp;
+  Board&            board;
+  GenmoveGtp<Uct>&  genmove_gtp;
+
+  uint   default_interval; // centiseconds
+  uint   max_moves;
+  uint   max_pv_length;
+  uint   max_playouts;     // 0 - until interrupted (async loop only)
+  uint   time_check_period;
+
+public:
+  AnalyzeGtp (Gtp& gtp_, Board& board_, GenmoveGtp<Uct>& genmove_gtp_)
+    : gtp (gtp_), board (board_), genmove_gtp (genmove_gtp_)
+  {
+    default_interval   = 100;
+    max_moves          = 10;
+    max_pv_length      = 10;
+    max_playouts       = 0;
+    time_check_period  = 100;
+
+    gtp.add_gtp_command (this, "lz-analyze");
+    gtp.add_interruptible_command ("lz-analyze");
+
+    gtp.add_gogui_param_uint ("analyze.params", "max_moves",     &max_moves);
+    gtp.add_gogui_param_uint ("analyze.params", "max_pv_length", &max_pv_length);
+    gtp.add_gogui_param_uint ("analyze.params", "max_playouts",  &max_playouts);
+  }
+
+  virtual GtpResult exec_command (const string& command, istream& params) {
+    if (command == "lz-analyze") {
+      Player player = board.act_player ();
+      uint   interval = default_interval;
+
+      string token;
+      while (params >> token) {
+        istringstream token_stream (token);
+        if (token_stream >> player) continue;
+        if (!string_to<uint> (token, &interval)) return GtpResult::syntax_error ();
+      }
+      if (interval == 0) interval = default_interval;
+
+      uint playout_limit = max_playouts;
+      if (!gtp.is_async () && playout_limit == 0) {
+        return GtpResult::failure ("max_playouts needed without async loop");
+      }
+
+      Uct* uct = genmove_gtp.get_engine ();
+      uct->root_ensure_children_legality (player);
+
+      gtp.stream_begin ();
+
+      double next_info = wall_clock_time () + interval / 100.0;
+      uint   playout_cnt = 0;
+      uint   descent_cnt = 0;
+
+      while (!uct->interrupted () &&
+             (playout_limit == 0 || playout_cnt < playout_limit)) {
+        playout_cnt += uct->do_playout (player);
+        descent_cnt++;
+
+        if (descent_cnt % time_check_period == 0 &&
+            wall_clock_time () >= next_info) {
+          gtp.stream (uct->root_info (max_moves, max_pv_length));
+          next_info += interval / 100.0;
+        }
+      }
+
+      gtp.stream (uct->root_info (max_moves, max_pv_length));
+
+      return GtpResult::streamed ();
+    }
+
+    assert (false);
+  }
+};
@@ -0,0 +1,148 @@
+#ifndef _ATOMIC_STAT_H_
+#define _ATOMIC_STAT_H_
+
+#include "cstdio"
+
+// Stat of a tree node that many threads may update at once. The visit
+// count is an integer and sample sums are fixed point, so all updates
+// are lock-free atomic adds and none is lost; float counts would also
+// stop growing at 2^24. Readers see each field atomically, but not all
+// of them from the same moment, which is good enough for find_uct_child.
+//
+// A virtual loss is a lost visit for the player to move into the node,
+// added while a thread is below it and removed by the real update, so
+// other threads spread to other children meanwhile.
+//
+// The stat starts with prior_visit_cnt virtual samples of -1 and 1
+// whose mean is prior_mean (prior knowledge of a move, see
+// MovePrior::prior).
+
+class AtomicStat {
+public:
+  static const long long sample_scale = 1 << 16; // samples are in -1 .. 1
+
+  AtomicStat () {
+    reset ();
+  }
+
+  void reset (uint prior_visit_cnt_ = 1, float prior_mean_ = 0.0) {
+    prior_visit_cnt    = prior_visit_cnt_;
+    prior_mean         = prior_mean_;
+    visit_cnt          = prior_visit_cnt;
+    sample_sum         = prior_sample_sum ();
+    square_sample_sum  = prior_square_sample_sum ();
+  }
+
+  void update (float sample) {
+    long long fixed = (long long) (sample * sample_scale);
+    __sync_fetch_and_add (&sample_sum, fixed);
+    __sync_fetch_and_add (&square_sample_sum, fixed * fixed / sample_scale);
+    __sync_fetch_and_add (&visit_cnt, 1);
+  }
+
+  // cnt samples at once
+  void update (float sample_sum_, float square_sample_sum_, uint cnt) {
+    __sync_fetch_and_add (&sample_sum, (long long) (sample_sum_ * sample_scale));
+    __sync_fetch_and_add (&square_sample_sum, (long long) (square_sample_sum_ * sample_scale));
+    __sync_fetch_and_add (&visit_cnt, cnt);
+  }
+
+  void add_virtual_loss (Player pl) {
+    __sync_fetch_and_add (&sample_sum, loss (pl));
+    __sync_fetch_and_add (&square_sample_sum, sample_scale);
+    __sync_fetch_and_add (&visit_cnt, 1);
+  }
+
+  void remove_virtual_loss (Player pl) {
+    __sync_fetch_and_sub (&sample_sum, loss (pl));
+    __sync_fetch_and_sub (&square_sample_sum, sample_scale);
+    __sync_fetch_and_sub (&visit_cnt, 1);
+  }
+
+  // adds the samples of an independent search of the same node, but
+  // not its prior; other has to be idle
+  void merge (const AtomicStat& other) {
+    __sync_fetch_and_add (&sample_sum, other.sample_sum - other.prior_sample_sum ());
+    __sync_fetch_and_add (&square_sample_sum,
+                          other.square_sample_sum - other.prior_square_sample_sum ());
+    __sync_fetch_and_add (&visit_cnt, other.visit_cnt - other.prior_visit_cnt);
+  }
+
+  float update_count () {
+    return visit_cnt;
+  }
+
+  float mean () { 
+    return float (sample_sum) / sample_scale / visit_cnt;
+  }
+
+  // of the real samples only, without the prior; 0 without samples
+  float sample_mean () {
+    uint cnt = visit_cnt - prior_visit_cnt;
+    if (cnt == 0) return 0.0;
+    return float (sample_sum - prior_sample_sum ()) / sample_scale / cnt;
+  }
+
+  float variance () {
+    // VX = E(X^2) - EX ^ 2
+    float m = mean ();
+    return float (square_sample_sum) / sample_scale / visit_cnt - m * m;
+  }
+
+  float std_dev () { 
+    return sqrt (variance ());
+  }
+
+  float std_err () {
+    return sqrt (variance () / visit_cnt);
+  } 
+
+  float ucb (Player pl, float explore_coeff) {
+    return 
+      (pl == Player::black () ? mean() : -mean()) +
+      sqrt (explore_coeff / update_count());
+  }
+
+  // UCB1-Tuned: the bonus shrinks with the variance of the samples,
+  // bounded by its own confidence term, so clearly won or lost moves
+  // (variance near 0 for samples of -1 and 1) get less exploration;
+  // never more than ucb gives
+  float ucb_tuned (Player pl, float explore_coeff) {
+    float n = update_count ();
+    float variance_bound = variance () + 4.0 * sqrt (2.0 * explore_coeff / n);
+    return 
+      (pl == Player::black () ? mean() : -mean()) +
+      sqrt (explore_coeff / n * min (variance_bound, float (1.0)));
+  }
+
+  string to_string (float minimal_update_count = 0.0) {
+    if (visit_cnt < minimal_update_count) return "           ";
+
+    ostringstream out;
+    char buf [100];
+    sprintf (buf, "%+3.3f(%5.0f)", mean(), update_count());
+    out << buf;
+    return out.str ();
+  }
+
+private:
+  static long long loss (Player pl) {
+    return pl == Player::black () ? -sample_scale : sample_scale;
+  }
+
+  long long prior_sample_sum () const {
+    return (long long) (prior_visit_cnt * prior_mean * sample_scale);
+  }
+
+  long long prior_square_sample_sum () const {
+    return (long long) prior_visit_cnt * sample_scale;
+  }
+
+  uint                prior_visit_cnt;
+  float               prior_mean;
+  volatile uint       visit_cnt;
+  volatile long long  sample_sum;
+  volatile long long  square_sample_sum;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cstdio>
+
+// ----------------------------------------------------------------------
+
+// --build-book <file> [depth] [width] [kplayouts] [komi]
+//
+// Searches the empty board with kplayouts thousand playouts (default
+// 1000) and stores the most visited move. The positions after the width
+// (default 3) most visited moves are searched the same way, down to
+// depth (default 6) moves, so the book answers also the opponent's
+// reasonable replies. Transpositions are searched once.
+
+class BookBuilder {
+public:
+  uint   depth;
+  uint   width;
+  uint   playouts;
+  float  komi;
+
+  map <uint64, BookEntry>  entries;
+
+public:
+  BookBuilder (uint depth_, uint width_, uint playouts_, float komi_) {
+    depth    = depth_;
+    width    = width_;
+    playouts = playouts_;
+    komi     = komi_;
+  }
+
+  void build (Board* board, uint ply) {
+    Player pl  = board->act_player ();
+    uint64 key = OpeningBook::key (board, pl);
+    if (entries.find (key) != entries.end ()) return;
+
+    Uct uct (*board);
+    uct.root_ensure_children_legality (pl);
+    uint playout_cnt = 0;
+    while (playout_cnt < playouts) playout_cnt += uct.do_playout (pl);
+
+    // children are gone with the next search, keep what is needed
+    vector <Node*> children;
+    node_for_each_child (uct.tree.history [0], child, children.push_back (child));
+    if (children.empty ()) return;
+    uint cnt = min (uint (children.size ()), max (width, uint (1)));
+    partial_sort (children.begin (), children.begin () + cnt, children.end (), more_visited);
+
+    BookEntry entry;
+    float mean = children [0]->stat.mean ();
+    if (children [0]->player != Player::black ()) mean = -mean;
+    entry.key    = key;
+    entry.vertex = children [0]->v.get_idx ();
+    entry.visits = uint (children [0]->stat.update_count ());
+    entry.mean   = mean;
+    entry.unused = 0;
+    entries [key] = entry;
+
+    printf ("%u entries, ply %u: %s %s visits %u mean %.3f\n",
+            uint (entries.size ()), ply, pl.to_string ().c_str (),
+            children [0]->v.to_string ().c_str (), entry.visits, mean);
+
+    if (ply + 1 >= depth) return;
+
+    vector <Vertex> replies;
+    rep (ii, cnt) replies.push_back (children [ii]->v);
+
+    rep (ii, replies.size ()) {
+      if (replies [ii] == Vertex::pass ()) continue;
+      Board child_board;
+      child_board.load (board);
+      if (!child_board.try_play (pl, replies [ii])) continue;
+      build (&child_board, ply + 1);
+    }
+  }
+
+  bool run (const string& file_name) {
+    Board board;
+    board.set_komi (-komi); // as the gtp komi command
+    build (&board, 0);
+
+    vector <BookEntry> list;
+    for (map <uint64, BookEntry>::iterator it = entries.begin ();
+         it != entries.end ();
+         it++) {
+      list.push_back (it->second);
+    }
+    return OpeningBook::write (file_name, list, board.komi ());
+  }
+};
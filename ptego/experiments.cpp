@@ -59,9 +59,11 @@ public:
   float       prior;
   bool        progress_dots;
   ExtPolicy policy;
+  const volatile bool* interrupt;
 
 public:
-  AllAsFirst (Gtp& gtp, Board& board_) : board (&board_), policy(global_random) { 
+  AllAsFirst (Gtp& gtp, Board& board_) 
+    : board (&board_), policy(global_random), interrupt (gtp.interrupt_flag ()) { 
     playout_no       = 50000;
     aaf_fraction     = 0.5;
     influence_scale  = 6.0;
@@ -81,6 +83,11 @@ public:
 		gtp.add_gogui_command (this, "dboard", "AAF.detect_ladders", "");
 		gtp.add_gogui_command (this, "dboard", "AAF.detect_ladders2", "");
 
+		// Dlugie analizy przerywamy, gdy przyjdzie kolejna komenda
+		gtp.add_interruptible_command ("AAF.move_value");
+		gtp.add_interruptible_command ("AAF.predict");
+		gtp.add_interruptible_command ("AAF.critical");
+
     gtp.add_gogui_param_float ("AAF.params", "prior",            &prior);
     gtp.add_gogui_param_float ("AAF.params", "aaf_fraction",     &aaf_fraction);
     gtp.add_gogui_param_float ("AAF.params", "influence_scale",  &influence_scale);
@@ -107,6 +114,7 @@ public:
       if (!(params >> player)) return GtpResult::syntax_error ();
       aaf_stats.reset (prior);
       rep (ii, playout_no) {
+        if (*interrupt) break;
         if (progress_dots && (ii * 20) % playout_no == 0) cerr << "." << flush;
         do_playout (board);
       }
@@ -128,7 +136,9 @@ public:
 			
 			vertex_for_each_all (v) { means[v] = 0.; }
 			
+			uint playout_cnt = 0;
 			rep (ii, 100000) { 
+				if (*interrupt) break;
 				Board b[1];
 				b->load(board);
 
@@ -136,9 +146,11 @@ public:
 				playout.run();
 
 				vertex_for_each_all (v) { means[v] += b->vertex_score(v); }
+				playout_cnt++;
 			}
 
-			vertex_for_each_all (v) { means [v] /= 100000.; }
+			if (playout_cnt > 0)
+				vertex_for_each_all (v) { means [v] /= float (playout_cnt); }
 
       return GtpResult::success (to_string_2d (means));
 		}
@@ -148,6 +160,7 @@ public:
 			PlayoutView view; 
 
 			rep (ii, 100000) { 
+				if (*interrupt) break;
 				Board board2[1];
 				board2->load(board);
 
@@ -0,0 +1,234 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <pthread.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------
+
+// Host mode (--host): one process serves many games. Each game has its
+// own board, gtp and engine and is addressed by id:
+//
+//   12 host.new g1
+//   13 game g1 play b e5
+//   14 game g1 genmove w
+//
+// Commands of one game run in order, commands of different games run in
+// parallel on a shared pool of worker threads and are answered (with the
+// id of the outer command) as soon as they finish. Only workers search,
+// so the node memory budget is split between them; root parallel helpers
+// would each need a pool of their own, so --root-parallel is ignored.
+
+class GameContext {
+public:
+  Gtp              gtp;
+  Board            board;
+  BasicGtp         basic_gtp;
+  GenmoveGtp<Uct>  genmove_gtp;
+
+  // guarded by HostGtp::mutex
+  deque <pair <string, string> >  pending; // id, command line
+  bool                            busy;    // a worker runs its command
+  bool                            queued;  // in HostGtp::runnable
+
+  GameContext () : basic_gtp (gtp, board), genmove_gtp (gtp, board) {
+    busy   = false;
+    queued = false;
+  }
+};
+
+class HostGtp : public GtpCommand {
+public:
+  static const uint min_pool_nodes = 10000;
+
+  Gtp&                          gtp;
+  map <string, GameContext*>    games;
+  deque <GameContext*>          runnable;
+  vector <pthread_t>            workers;
+  uint                          worker_cnt;
+  bool                          stopping;
+  pthread_mutex_t               mutex;
+  pthread_cond_t                work_cond;
+
+public:
+  HostGtp (Gtp& gtp_, uint thread_cnt, uint memory_mb) : gtp (gtp_) {
+    stopping   = false;
+    worker_cnt = 0;
+    pthread_mutex_init (&mutex, NULL);
+    pthread_cond_init (&work_cond, NULL);
+
+    if (thread_cnt == 0) thread_cnt = 1;
+
+    if (uct_root_thread_cnt > 1) {
+      cerr << "--root-parallel is ignored with --host" << endl;
+      uct_root_thread_cnt = 1;
+    }
+
+    uint64 node_size = sizeof (Node);
+#ifdef USE_PLAYOUT_VIEW
+    node_size += sizeof (PlayoutView); // nodes get a view once visited
+#endif
+    uint64 nodes = uint64 (memory_mb) * 1024 * 1024 / node_size / thread_cnt;
+    uct_max_nodes = nodes < min_pool_nodes ? min_pool_nodes : uint (nodes);
+
+    rep (ii, thread_cnt) {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, worker_main, this) != 0) break;
+      workers.push_back (thread);
+    }
+
+    gtp.add_gtp_command (this, "host.new");
+    gtp.add_gtp_command (this, "host.delete");
+    gtp.add_gtp_command (this, "host.list");
+    gtp.add_gtp_command (this, "game");
+  }
+
+  ~HostGtp () {
+    shutdown ();
+    for (map <string, GameContext*>::iterator it = games.begin();
+         it != games.end();
+         it++) {
+      delete it->second;
+    }
+    pthread_cond_destroy (&work_cond);
+    pthread_mutex_destroy (&mutex);
+  }
+
+  // interrupts running searches and waits for the workers
+  void shutdown () {
+    pthread_mutex_lock (&mutex);
+    stopping = true;
+    for (map <string, GameContext*>::iterator it = games.begin();
+         it != games.end();
+         it++) {
+      it->second->pending.clear ();
+      it->second->gtp.interrupt_command ();
+    }
+    pthread_cond_broadcast (&work_cond);
+    pthread_mutex_unlock (&mutex);
+
+    rep (ii, workers.size ()) pthread_join (workers [ii], NULL);
+    workers.clear ();
+  }
+
+  static void* worker_main (void* host_ptr) {
+    HostGtp* host = (HostGtp*) host_ptr;
+    thread_node_pool (); // allocated once, used by every game this thread runs
+
+    pthread_mutex_lock (&host->mutex);
+    set_thread_random_stream (++host->worker_cnt);
+    while (true) {
+      while (host->runnable.empty () && !host->stopping)
+        pthread_cond_wait (&host->work_cond, &host->mutex);
+      if (host->stopping) break;
+
+      GameContext* game = host->runnable.front ();
+      host->runnable.pop_front ();
+      game->queued = false;
+      game->busy   = true;
+
+      pair <string, string> cmd = game->pending.front ();
+      game->pending.pop_front ();
+      pthread_mutex_unlock (&host->mutex);
+
+      GtpResult result = game->gtp.exec_line (cmd.second);
+      host->gtp.respond (cmd.first, result);
+
+      pthread_mutex_lock (&host->mutex);
+      game->busy = false;
+      if (!game->pending.empty ()) host->schedule (game);
+    }
+    pthread_mutex_unlock (&host->mutex);
+    return NULL;
+  }
+
+  // mutex held
+  void schedule (GameContext* game) {
+    if (game->busy || game->queued || game->pending.empty ()) return;
+    game->queued = true;
+    runnable.push_back (game);
+    pthread_cond_signal (&work_cond);
+  }
+
+  virtual GtpResult exec_command (const string& command, istream& params) {
+    string game_id;
+    if (command != "host.list" && !(params >> game_id))
+      return GtpResult::syntax_error ();
+
+    pthread_mutex_lock (&mutex);
+    GtpResult result = exec_locked (command, game_id, params);
+    pthread_mutex_unlock (&mutex);
+    return result;
+  }
+
+private:
+
+  GtpResult exec_locked (const string& command, const string& game_id, istream& params) {
+    map <string, GameContext*>::iterator game_it = games.find (game_id);
+
+    if (command == "host.new") {
+      if (game_it != games.end ()) return GtpResult::failure ("game exists: " + game_id);
+      games [game_id] = new GameContext ();
+      return GtpResult::success ();
+    }
+
+    if (command == "host.list") {
+      ostringstream response;
+      for (game_it = games.begin(); game_it != games.end(); game_it++) {
+        response << game_it->first << " "
+                 << (game_it->second->busy ? "busy" : "idle") << " "
+                 << game_it->second->pending.size () << endl;
+      }
+      return GtpResult::success (response.str ());
+    }
+
+    if (game_it == games.end ()) return GtpResult::failure ("no such game: " + game_id);
+    GameContext* game = game_it->second;
+
+    if (command == "host.delete") {
+      if (game->busy || game->queued)
+        return GtpResult::failure ("game busy: " + game_id);
+      delete game;
+      games.erase (game_it);
+      return GtpResult::success ();
+    }
+
+    if (command == "game") {
+      string line;
+      getline (params, line);
+
+      // without the asynchronous loop nobody could read a late answer
+      if (!gtp.is_async ()) {
+        if (game->busy || game->queued)
+          return GtpResult::failure ("game busy: " + game_id);
+        return game->gtp.exec_line (line);
+      }
+
+      game->pending.push_back (make_pair (gtp.current_command_id (), line));
+      schedule (game);
+      return GtpResult::deferred ();
+    }
+
+    assert (false);
+  }
+};
@@ -27,7 +27,15 @@
 #include "benchmark.h"
 #include "view.h"
 #include "uct.cpp"
+#include "root_parallel.cpp"
 #include "experiments.cpp"
+#include "analyze.cpp"
+#include "host.cpp"
+#include "uct_benchmark.cpp"
+#include "match.cpp"
+#include "prediction.cpp"
+#include "book.cpp"
+#include "tree_gtp.cpp"
 
 Gtp      gtp;
 Board    board;
@@ -36,14 +44,29 @@ SgfTree  sgf_tree;
 BasicGtp    basic_gtp (gtp, board);
 SgfGtp      sgf_gtp   (gtp, sgf_tree, board);
 AllAsFirst  aaf (gtp, board);
-
 GenmoveGtp<Uct>  genmove_gtp (gtp, board);
 
+AnalyzeGtp  analyze_gtp (gtp, board, genmove_gtp);
+ProfileGtp  profile_gtp (gtp);
+TreeGtp     tree_gtp (gtp, genmove_gtp);
+
 int main(int argc, char** argv) {
   // no buffering to work well with gogui
   setbuf (stdout, NULL);
   setbuf (stderr, NULL);
 
+  HostGtp* host = NULL;
+  uint host_thread_cnt = 0;
+  uint host_memory_mb  = 0;
+  int  benchmark_playout_cnt = -1;
+  bool perf_counters   = false;
+  vector <string> benchmark_positions;
+  uint uct_benchmark_thread_cnt = 0;
+  uint board_benchmark_rep_cnt = 0;
+  string board_benchmark_baseline;
+  uint pool_benchmark_thread_cnt = 0;
+  uint pool_benchmark_op_cnt = 10000000;
+
   reps (ii, 1, argc) {
     string arg = argv[ii];
 
@@ -67,12 +90,247 @@ int main(int argc, char** argv) {
           ii += 1;
         }
       }
-      playout_cnt *= 1000;
-      cout << "Benchmarking, please wait ..." << flush;
-      cout << Benchmark::run(playout_cnt) << endl;
+      benchmark_playout_cnt = playout_cnt * 1000;
+      // position files (ascii board or sgf[:node_cnt])
+      while (ii+1 < (uint)argc && argv[ii+1][0] != '-') {
+        ii += 1;
+        benchmark_positions.push_back (argv[ii]);
+      }
+      continue;
+    }
+
+    if (arg == "--board-benchmark") {
+      board_benchmark_rep_cnt = 1000;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &board_benchmark_rep_cnt)) {
+        ii += 1;
+      }
+      if (ii+1 < (uint)argc && argv[ii+1][0] != '-') {
+        ii += 1;
+        board_benchmark_baseline = argv[ii];
+      }
+      continue;
+    }
+
+    if (arg == "--pool-benchmark") {
+      pool_benchmark_thread_cnt = 4;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &pool_benchmark_thread_cnt)) {
+        ii += 1;
+        if (ii+1 < (uint)argc &&
+            string_to<uint>(argv[ii+1], &pool_benchmark_op_cnt)) {
+          ii += 1;
+        }
+      }
+      continue;
+    }
+
+    if (arg == "--uct-benchmark") {
+      uct_benchmark_thread_cnt = 1;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &uct_benchmark_thread_cnt)) {
+        ii += 1;
+      }
+      while (ii+1 < (uint)argc && argv[ii+1][0] != '-') {
+        ii += 1;
+        benchmark_positions.push_back (argv[ii]);
+      }
+      continue;
+    }
+
+    if (arg == "--match") {
+      MatchConfig config [2];
+      rep (side, 2) {
+        ii += 1;
+        if (ii == (uint)argc || !config [side].parse (argv[ii])) {
+          cerr << "Fatal: --match needs two configurations, "
+               << "e.g. playouts=20000,explore_rate=0.8" << endl;
+          return 1;
+        }
+      }
+      uint max_games  = 1000;
+      uint thread_cnt = sysconf (_SC_NPROCESSORS_ONLN);
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &max_games)) {
+        ii += 1;
+        if (ii+1 < (uint)argc &&
+            string_to<uint>(argv[ii+1], &thread_cnt)) {
+          ii += 1;
+        }
+      }
+      Match match (config [0], config [1], max_games, thread_cnt);
+      cout << match.run ();
       return 0;
     }
+
+    if (arg == "--patterns") {
+      if (ii+1 == (uint)argc) {
+        cerr << "Fatal: no pattern file given" << endl;
+        return 1;
+      }
+      ii += 1;
+      playout_patterns = new PatternTable;
+      if (!playout_patterns->load (argv[ii])) {
+        cerr << "Fatal: cannot load patterns: " << argv[ii] << endl;
+        return 1;
+      }
+      continue;
+    }
+
+    if (arg == "--learn-patterns") {
+      if (ii+2 >= (uint)argc) {
+        cerr << "Fatal: --learn-patterns <output> <sgf file> ..." << endl;
+        return 1;
+      }
+      string out_file = argv[ii+1];
+      vector <string> sgf_files (argv + ii + 2, argv + argc);
+      PatternTable* table = new PatternTable;
+      cout << PatternLearning::learn (sgf_files, table);
+      if (!table->save (out_file)) {
+        cerr << "Fatal: cannot write " << out_file << endl;
+        return 1;
+      }
+      delete table;
+      return 0;
+    }
+
+    if (arg == "--predict") {
+      string mode = ii+1 < (uint)argc ? argv[ii+1] : "";
+      if (mode != "policy" && mode != "uct") {
+        cerr << "Fatal: --predict <policy|uct> [count] <sgf file> ..." << endl;
+        return 1;
+      }
+      ii += 1;
+      uint count = 0;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &count)) {
+        ii += 1;
+      }
+      vector <string> sgf_files (argv + ii + 1, argv + argc);
+      PredictionBenchmark prediction (mode == "uct", count);
+      cout << prediction.run (sgf_files);
+      return 0;
+    }
+
+    if (arg == "--book") {
+      if (ii+1 == (uint)argc) {
+        cerr << "Fatal: no book file given" << endl;
+        return 1;
+      }
+      ii += 1;
+      opening_book = new OpeningBook;
+      if (!opening_book->open (argv[ii])) {
+        cerr << "Fatal: cannot load book: " << argv[ii] << endl;
+        return 1;
+      }
+      continue;
+    }
+
+    if (arg == "--build-book") {
+      if (ii+1 == (uint)argc) {
+        cerr << "Fatal: --build-book <file> [depth] [width] [kplayouts] [komi]" << endl;
+        return 1;
+      }
+      ii += 1;
+      string book_file = argv[ii];
+      uint  book_param [3] = { 6, 3, 1000 }; // depth, width, kplayouts
+      float book_komi = 6.5;
+      rep (pp, 3) {
+        if (ii+1 < (uint)argc && string_to<uint>(argv[ii+1], &book_param [pp])) ii += 1;
+      }
+      if (ii+1 < (uint)argc && string_to<float>(argv[ii+1], &book_komi)) ii += 1;
+
+      BookBuilder builder (book_param [0], book_param [1], book_param [2] * 1000, book_komi);
+      if (!builder.run (book_file)) {
+        cerr << "Fatal: cannot write " << book_file << endl;
+        return 1;
+      }
+      return 0;
+    }
+
+    if (arg == "--perf-counters") {
+      perf_counters = true;
+      continue;
+    }
     
+    if (arg == "--host") {
+      host_thread_cnt = sysconf (_SC_NPROCESSORS_ONLN);
+      host_memory_mb  = 1024;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &host_thread_cnt)) {
+        ii += 1;
+        if (ii+1 < (uint)argc &&
+            string_to<uint>(argv[ii+1], &host_memory_mb)) {
+          ii += 1;
+        }
+      }
+      if (host_thread_cnt == 0) {
+        cerr << "Fatal: --host needs at least one thread" << endl;
+        return 1;
+      }
+      continue;
+    }
+
+    if (arg == "--root-parallel") {
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &uct_root_thread_cnt)) {
+        ii += 1;
+        continue;
+      } else {
+        cerr << "Fatal: no thread count given" << endl;
+        return 1;
+      }
+    }
+
+    if (arg == "--ucb1-tuned") {
+      uct_ucb1_tuned = true;
+      continue;
+    }
+
+    if (arg == "--leaf-playouts") {
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &uct_leaf_playout_cnt)) {
+        ii += 1;
+        continue;
+      } else {
+        cerr << "Fatal: no playout count given" << endl;
+        return 1;
+      }
+    }
+
+    if (arg == "--dynamic-komi") {
+      uct_dynamic_komi_max = 10.0;
+      if (ii+1 < (uint)argc &&
+          string_to<float>(argv[ii+1], &uct_dynamic_komi_max)) {
+        ii += 1;
+      }
+      continue;
+    }
+
+    if (arg == "--prior-knowledge") {
+      uct_prior_knowledge = true;
+      continue;
+    }
+
+    if (arg == "--widening") {
+      uct_widening_base = 5;
+      if (ii+1 < (uint)argc &&
+          string_to<uint>(argv[ii+1], &uct_widening_base)) {
+        ii += 1;
+      }
+      continue;
+    }
+
+    if (arg == "--huge-pages") {
+      uct_huge_pages = true;
+      continue;
+    }
+
+    if (arg == "--prefault") {
+      uct_prefault_pool = true;
+      continue;
+    }
+
     if (arg == "--run-gtp-file" || arg == "-r") {
       if (ii+1 == (uint)argc) {
         cerr << "Fatal: no config file given" << endl;
@@ -91,7 +349,38 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  gtp.run_loop (cin, cout);
+  if (benchmark_playout_cnt >= 0) {
+    cout << "Benchmarking, please wait ..." << flush;
+    cout << Benchmark::run(benchmark_playout_cnt, perf_counters, benchmark_positions) << endl;
+    return 0;
+  }
+
+  if (board_benchmark_rep_cnt > 0) {
+    cout << BoardBenchmark::run (board_benchmark_rep_cnt, board_benchmark_baseline);
+    return 0;
+  }
+
+  if (pool_benchmark_thread_cnt > 0) {
+    cout << PoolBenchmark::run (pool_benchmark_thread_cnt, pool_benchmark_op_cnt);
+    return 0;
+  }
+
+  if (uct_benchmark_thread_cnt > 0) {
+    UctBenchmark uct_benchmark (uct_benchmark_thread_cnt, benchmark_positions);
+    cout << uct_benchmark.run ();
+    return 0;
+  }
+
+  // node pools are allocated (and prefaulted) before the first genmove
+  if (host_thread_cnt > 0) {
+    host = new HostGtp (gtp, host_thread_cnt, host_memory_mb);
+  } else {
+    thread_node_pool ();
+  }
+
+  gtp.run_loop_async (cin, cout);
+
+  delete host;
 
   return 0;
 }
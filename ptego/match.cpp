@@ -0,0 +1,250 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cmath>
+#include <cstdio>
+#include <pthread.h>
+
+// ----------------------------------------------------------------------
+
+// Uct parameters of one side of a match, given as
+// "playouts=20000,explore_rate=0.8,mature=100,resign=0.95,tuned=1,widening=5,prior=1,leaf=4,dynkomi=10".
+// Unset keys keep the Uct defaults.
+
+class MatchConfig {
+public:
+  string     name;
+  UctParams  params;
+
+public:
+
+  bool parse (const string& config) {
+    name = config;
+    istringstream in (config);
+    string item;
+    while (getline (in, item, ',')) {
+      string::size_type eq = item.find ('=');
+      if (eq == string::npos) return false;
+      string key   = item.substr (0, eq);
+      string value = item.substr (eq + 1);
+      bool ok =
+        key == "playouts"     ? string_to (value, &params.genmove_playout_cnt)           :
+        key == "explore_rate" ? string_to (value, &params.explore_rate)                  :
+        key == "tuned"        ? string_to (value, &params.ucb1_tuned)                    :
+        key == "mature"       ? string_to (value, &params.mature_update_count_threshold) :
+        key == "widening"     ? string_to (value, &params.widening_base)                 :
+        key == "prior"        ? string_to (value, &params.prior_knowledge)               :
+        key == "leaf"         ? string_to (value, &params.leaf_playout_cnt)              :
+        key == "dynkomi"      ? string_to (value, &params.dynamic_komi_max)              :
+        key == "resign"       ? string_to (value, &params.resign_mean)                   :
+        false;
+      if (!ok) return false;
+    }
+    return true;
+  }
+
+  void apply (Uct* uct) const {
+    uct->params = params;
+  }
+};
+
+// ----------------------------------------------------------------------
+
+// --match <config A> <config B> [max_games] [threads]
+//
+// Self-play of two configurations in one process, one game per worker
+// thread at a time. A takes black in even games and white in odd ones.
+// After every game a sequential probability ratio test of
+// H0: elo (A - B) = elo0 against H1: elo = elo1 decides whether to stop;
+// otherwise the match ends after max_games. Games still running when
+// the match is decided are interrupted and not counted.
+
+class Match {
+public:
+  MatchConfig  config [2];   // A, B
+  uint         max_games;
+  uint         thread_cnt;
+  float        komi;         // white's bonus, as in gtp
+
+  float        elo0;
+  float        elo1;
+  float        alpha;
+  float        beta;
+
+  // guarded by mutex
+  uint         worker_cnt;
+  uint         next_game;
+  uint         finished;
+  uint         wins [2];           // of A, B
+  uint         wins_as_black [2];
+  double       llr;
+  string       verdict;
+  volatile bool stop;
+
+  pthread_mutex_t  mutex;
+
+public:
+  Match (const MatchConfig& a, const MatchConfig& b, uint max_games_, uint thread_cnt_) {
+    config [0]  = a;
+    config [1]  = b;
+    max_games   = max_games_;
+    thread_cnt  = thread_cnt_ > 0 ? thread_cnt_ : 1;
+    komi        = 6.5;
+
+    elo0  = 0.0;
+    elo1  = 35.0;
+    alpha = 0.05;
+    beta  = 0.05;
+
+    worker_cnt = 0;
+    next_game = 0;
+    finished  = 0;
+    rep (ii, 2) {
+      wins [ii] = 0;
+      wins_as_black [ii] = 0;
+    }
+    llr  = 0.0;
+    stop = false;
+    pthread_mutex_init (&mutex, NULL);
+  }
+
+  ~Match () {
+    pthread_mutex_destroy (&mutex);
+  }
+
+  static double elo_to_score (double elo) {
+    return 1.0 / (1.0 + pow (10.0, -elo / 400.0));
+  }
+
+  // mutex held
+  void update_sprt () {
+    double p0 = elo_to_score (elo0);
+    double p1 = elo_to_score (elo1);
+    llr = wins [0] * log (p1 / p0) + wins [1] * log ((1.0 - p1) / (1.0 - p0));
+
+    if (llr >= log ((1.0 - beta) / alpha)) {
+      verdict = "H1 accepted, A is stronger";
+    } else if (llr <= log (beta / (1.0 - alpha))) {
+      verdict = "H0 accepted, A is not stronger";
+    }
+    if (verdict != "" || finished >= max_games) stop = true;
+  }
+
+  // index of the winning side (0 - A, 1 - B), -1 when interrupted
+  int play_game (uint game_no) {
+    Board board;
+    board.set_komi (-komi); // as the gtp komi command
+    uint black_side = game_no % 2;
+
+    Uct  uct_a (board);
+    Uct  uct_b (board);
+    Uct* uct [2] = { &uct_a, &uct_b };
+    rep (side, 2) {
+      config [side].apply (uct [side]);
+      uct [side]->interrupt = &stop;
+    }
+
+    while (true) {
+      Player pl   = board.act_player ();
+      uint   side = pl == Player::black () ? black_side : 1 - black_side;
+
+      Vertex v = uct [side]->genmove (pl);
+      if (stop) return -1;
+
+      if (v == Vertex::resign ()) return 1 - side;
+      if (board.try_play (pl, v) == false) return 1 - side;
+
+      if (board.both_player_pass () || board.move_no >= max_game_length - 1) {
+        uint winner_black = board.tt_score () > 0;
+        return winner_black ? black_side : 1 - black_side;
+      }
+    }
+  }
+
+  static void* worker_main (void* match_ptr) {
+    Match* match = (Match*) match_ptr;
+
+    pthread_mutex_lock (&match->mutex);
+    set_thread_random_stream (++match->worker_cnt);
+    pthread_mutex_unlock (&match->mutex);
+
+    while (true) {
+      pthread_mutex_lock (&match->mutex);
+      if (match->stop || match->next_game >= match->max_games) {
+        pthread_mutex_unlock (&match->mutex);
+        break;
+      }
+      uint game_no = match->next_game++;
+      pthread_mutex_unlock (&match->mutex);
+
+      int winner = match->play_game (game_no);
+      if (winner < 0) break;
+
+      pthread_mutex_lock (&match->mutex);
+      if (!match->stop) {
+        match->finished++;
+        match->wins [winner]++;
+        if (uint (winner) == game_no % 2) match->wins_as_black [winner]++;
+        match->update_sprt ();
+        printf ("game %u: %s won as %s, A %u : %u B, llr %.3f\n",
+                game_no, winner == 0 ? "A" : "B",
+                uint (winner) == game_no % 2 ? "black" : "white",
+                match->wins [0], match->wins [1], match->llr);
+      }
+      pthread_mutex_unlock (&match->mutex);
+    }
+    return NULL;
+  }
+
+  string run () {
+    vector <pthread_t> workers;
+    rep (ii, thread_cnt) {
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, worker_main, this) != 0) break;
+      workers.push_back (thread);
+    }
+    rep (ii, workers.size ()) pthread_join (workers [ii], NULL);
+
+    ostringstream out;
+    char buf [200];
+    double score = finished > 0 ? double (wins [0]) / finished : 0.5;
+    double error = finished > 0 ? 1.96 * sqrt (score * (1.0 - score) / finished) : 0.0;
+
+    out << "A: " << config [0].name << endl
+        << "B: " << config [1].name << endl;
+    sprintf (buf, "%u games at komi %.1f, A %u : %u B (as black A %u, B %u)",
+             finished, komi, wins [0], wins [1], wins_as_black [0], wins_as_black [1]);
+    out << buf << endl;
+    sprintf (buf, "A score %.3f +- %.3f", score, error);
+    out << buf;
+    if (score > 0.0 && score < 1.0) {
+      sprintf (buf, ", elo %+.0f", -400.0 * log10 (1.0 / score - 1.0));
+      out << buf;
+    }
+    out << endl;
+    sprintf (buf, "sprt elo0 %.0f elo1 %.0f: llr %.3f (%.3f .. %.3f)",
+             elo0, elo1, llr, log (beta / (1.0 - alpha)), log ((1.0 - beta) / alpha));
+    out << buf << ", " << (verdict != "" ? verdict : "undecided") << endl;
+    return out.str ();
+  }
+};
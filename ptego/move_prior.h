@@ -0,0 +1,152 @@
+#ifndef _MOVE_PRIOR_H_
+#define _MOVE_PRIOR_H_
+
+#include "pattern.h"
+
+// Cheap knowledge about the moves of one position, for the tree when it
+// grows. strength orders moves (progressive widening adds children
+// strongest first): with --patterns a move is as strong as its learned
+// features, otherwise the same features (pattern.h) get a few hand set
+// weights. prior seeds the stat of a new child with virtual wins or
+// losses for tactical features.
+
+class MovePrior {
+public:
+  MovePrior (Board* board_, Player pl_)
+    : board (board_), pl (pl_), recent_atari (board_, pl_)
+  {
+  }
+
+  // relative strength, 0 for moves that are not worth a child
+  float strength (Vertex v) {
+    if (v == Vertex::pass ()) return pass_gamma;
+    if (!board->is_pseudo_legal (pl, v) || is_suicide (v)) return 0.0;
+
+    uint local = Pattern::local (board, v);
+    uint atari = recent_atari.atari (v);
+    if (playout_patterns != NULL)
+      return playout_patterns->strength (Pattern::pattern3x3 (board, v, pl), local, atari);
+
+    float ret = local_gamma [local] * atari_gamma [atari];
+    if (board->is_eyelike (pl, v)) ret *= eyelike_gamma;
+    return ret;
+  }
+
+  // virtual visits and their mean, for pl (-1 .. 1), of a new child
+  void prior (Vertex v, uint* visit_cnt, float* mean) {
+    float visits = 1.0;
+    float sum    = 0.0;
+    #define add_prior(n, sample) do { visits += (n); sum += (n) * (sample); } while (false)
+
+    if (v != Vertex::pass ()) {
+      uint atari = recent_atari.atari (v);
+      if (atari == 2) add_prior (capture_visits, 1.0);
+      if (atari == 1) {
+        // the playouts' reader: no recursion, at most 48 plies deep
+        bool escapes = board->is_ladder_norec (v, pl) == pl;
+        add_prior (escape_visits, escapes ? 1.0 : -1.0);
+      }
+      if (board->is_eyelike (pl, v)) {
+        add_prior (bad_shape_visits, -1.0);
+      } else {
+        if (is_self_atari (v))               add_prior (self_atari_visits, -1.0);
+        if (is_empty_triangle (v))           add_prior (bad_shape_visits,  -1.0);
+        if (is_lonely_edge (v))              add_prior (bad_shape_visits,  -1.0);
+      }
+    }
+
+    #undef add_prior
+    *visit_cnt = uint (visits);
+    *mean      = sum / visits;
+  }
+
+  // not an eye suicide (is_pseudo_legal checks those), but a move that
+  // takes the last liberty of its own chains and captures nothing
+  bool is_suicide (Vertex v) {
+    return liberty_cnt_after (v) == 0;
+  }
+
+  bool is_self_atari (Vertex v) {
+    return liberty_cnt_after (v) == 1;
+  }
+
+  // liberties of the chain of a move, 2 stands for 2 or more; chains
+  // whose atari Board::in_atari misses count as having more liberties
+  uint liberty_cnt_after (Vertex v) {
+    uint ret = 0;
+    vertex_for_each_4_nbr (v, nbr, {
+      Color color = board->color_at [nbr];
+      if (color == Color::empty ()) ret++;
+      if (color.is_player ()) {
+        bool last_liberty = board->in_atari (nbr) == v;
+        // joins an own chain with other liberties or captures
+        if ((color.to_player () == pl) != last_liberty) ret += 2;
+      }
+    });
+    return min (ret, uint (2));
+  }
+
+  // two own stones and an empty point in one of the 2x2 squares of v
+  bool is_empty_triangle (Vertex v) {
+    return
+      is_empty_triangle (v.N (), v.E (), v.NE ()) ||
+      is_empty_triangle (v.E (), v.S (), v.SE ()) ||
+      is_empty_triangle (v.S (), v.W (), v.SW ()) ||
+      is_empty_triangle (v.W (), v.N (), v.NW ());
+  }
+
+  // on the first line with no stone around
+  bool is_lonely_edge (Vertex v) {
+    bool edge  = false;
+    bool stone = false;
+    vertex_for_each_4_nbr (v, nbr, {
+      if (board->color_at [nbr] == Color::off_board ()) edge = true;
+      if (board->color_at [nbr].is_player ()) stone = true;
+    });
+    Vertex diagonal [4] = { v.NW (), v.NE (), v.SW (), v.SE () };
+    rep (ii, 4) if (board->color_at [diagonal [ii]].is_player ()) stone = true;
+    return edge && !stone;
+  }
+
+private:
+  bool is_empty_triangle (Vertex a, Vertex b, Vertex c) {
+    uint own_cnt = 0, empty_cnt = 0;
+    Vertex square [3] = { a, b, c };
+    rep (ii, 3) {
+      Color color = board->color_at [square [ii]];
+      if (color == Color (pl))      own_cnt++;
+      if (color == Color::empty ()) empty_cnt++;
+    }
+    return own_cnt == 2 && empty_cnt == 1;
+  }
+
+  static const uint  capture_visits;
+  static const uint  escape_visits;
+  static const uint  self_atari_visits;
+  static const uint  bad_shape_visits;
+
+  static const float pass_gamma;
+  static const float eyelike_gamma;
+  static const float local_gamma [Pattern::local_cnt];
+  static const float atari_gamma [Pattern::atari_cnt];
+
+  Board*                board;
+  Player                pl;
+  Pattern::RecentAtari  recent_atari;
+};
+
+const uint  MovePrior::capture_visits    = 20;
+const uint  MovePrior::escape_visits     = 20;
+const uint  MovePrior::self_atari_visits = 20;
+const uint  MovePrior::bad_shape_visits  = 10;
+
+const float MovePrior::pass_gamma    = 0.01;
+const float MovePrior::eyelike_gamma = 0.05;
+
+// far, N/E/W/S, diagonal, two lines away
+const float MovePrior::local_gamma [Pattern::local_cnt] = { 1.0, 3.0, 2.0, 1.5 };
+
+// none, saves own, takes a liberty of the opponent
+const float MovePrior::atari_gamma [Pattern::atari_cnt] = { 1.0, 5.0, 8.0 };
+
+#endif
@@ -0,0 +1,152 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <algorithm>
+#include <cstdio>
+
+// ----------------------------------------------------------------------
+
+// --predict <policy|uct> [count] <sgf file> ...
+//
+// Move prediction on game records: at every position of the main lines
+// the candidate moves are ranked and the rank of the move actually
+// played is counted. "policy" samples ExtPolicy count times (default
+// 200) and ranks moves by how often it chose them; "uct" runs count
+// playouts (default 1000) and ranks the root children by visits.
+// Reports top-1 and top-5 rates and the time of one prediction.
+
+class PredictionBenchmark {
+public:
+  static const uint top_cnt = 5;
+
+  bool  use_uct;
+  uint  count;
+
+  uint    position_cnt;
+  uint    hit_cnt [top_cnt];   // played move at rank ii
+  double  seconds;
+
+public:
+  PredictionBenchmark (bool use_uct_, uint count_) {
+    use_uct  = use_uct_;
+    count    = count_ > 0 ? count_ : (use_uct ? 1000 : 200);
+    position_cnt = 0;
+    rep (ii, top_cnt) hit_cnt [ii] = 0;
+    seconds = 0.0;
+  }
+
+  static bool higher (pair <float, uint> a, pair <float, uint> b) {
+    return a.first > b.first;
+  }
+
+  // (score, vertex index) of every candidate
+  void rank_policy (Board* board, vector <pair <float, uint> >* ranked) {
+    FastMap <Vertex, uint> chosen;
+    vertex_for_each_all (v) chosen [v] = 0;
+
+    ExtPolicy policy (thread_random ());
+    Board     tmp_board;
+    rep (ii, count) {
+      tmp_board.load (board);
+      policy.play_move (&tmp_board);
+      Move move = tmp_board.move_history [tmp_board.move_no - 1];
+      chosen [move.get_vertex ()]++;
+    }
+
+    vertex_for_each_all (v)
+      if (chosen [v] > 0) ranked->push_back (make_pair (float (chosen [v]), v.get_idx ()));
+  }
+
+  void rank_uct (Board* board, vector <pair <float, uint> >* ranked) {
+    Player player = board->act_player ();
+    Uct uct (*board);
+    uct.root_ensure_children_legality (player);
+    uint playout_cnt = 0;
+    while (playout_cnt < count) playout_cnt += uct.do_playout (player);
+
+    Node* root = uct.tree.history [0];
+    node_for_each_child (root, child, {
+      ranked->push_back (make_pair (child->stat.update_count (), child->v.get_idx ()));
+    });
+  }
+
+  void predict (Board* board, Vertex played) {
+    vector <pair <float, uint> > ranked;
+
+    double begin = wall_clock_time ();
+    if (use_uct) rank_uct (board, &ranked); else rank_policy (board, &ranked);
+    uint cnt = min (uint (ranked.size ()), top_cnt);
+    partial_sort (ranked.begin (), ranked.begin () + cnt, ranked.end (), higher);
+    seconds += wall_clock_time () - begin;
+
+    position_cnt++;
+    rep (ii, cnt) {
+      if (ranked [ii].second == played.get_idx ()) {
+        hit_cnt [ii]++;
+        break;
+      }
+    }
+  }
+
+  string run (const vector <string>& sgf_files) {
+    rep (ff, sgf_files.size ()) {
+      SgfScanner scanner;
+      SgfGame    game;
+      if (!scanner.open (sgf_files [ff])) {
+        cerr << "cannot open " << sgf_files [ff] << endl;
+        continue;
+      }
+      while (scanner.next_game (&game)) {
+        Board board;
+        if (!game.replay (&board, 0)) continue;
+        rep (mm, game.moves.size ()) {
+          Player pl = game.moves [mm].get_player ();
+          Vertex v  = game.moves [mm].get_vertex ();
+          if (v != Vertex::pass () && !v.is_on_board ()) break;
+          if (!board.is_pseudo_legal (pl, v)) break;
+          if (v != Vertex::pass () && pl == board.act_player ()) predict (&board, v);
+          board.play_legal (pl, v);
+          if (board.last_move_status != Board::play_ok) break;
+        }
+      }
+    }
+
+    ostringstream out;
+    char buf [200];
+    if (position_cnt == 0) return "no positions\n";
+
+    uint top = 0;
+    sprintf (buf, "%s, %u %s, %u positions",
+             use_uct ? "uct" : "policy", count, use_uct ? "playouts" : "samples",
+             position_cnt);
+    out << buf << endl;
+    rep (ii, top_cnt) {
+      top += hit_cnt [ii];
+      sprintf (buf, "top-%u %6.2f%%", ii + 1, 100.0 * top / position_cnt);
+      out << buf << endl;
+    }
+    sprintf (buf, "%.3f ms per prediction", 1000.0 * seconds / position_cnt);
+    out << buf << endl;
+    return out.str ();
+  }
+};
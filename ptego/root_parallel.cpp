@@ -0,0 +1,143 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// ----------------------------------------------------------------------
+
+RootParallel::RootParallel (uint helper_cnt) {
+  pthread_mutex_init (&mutex, NULL);
+  pthread_cond_init (&cond, NULL);
+  generation  = 0;
+  done_cnt    = 0;
+  stopping    = false;
+  master      = NULL;
+  playout_cnt = 0;
+
+  rep (ii, helper_cnt) {
+    Helper* helper = new Helper;
+    helper->owner = this;
+    helper->idx   = ii;
+    helper->uct   = NULL;
+    pthread_t thread;
+    if (pthread_create (&thread, NULL, helper_main, helper) != 0) {
+      delete helper;
+      break;
+    }
+    helpers.push_back (helper);
+    threads.push_back (thread);
+  }
+}
+
+RootParallel::~RootParallel () {
+  pthread_mutex_lock (&mutex);
+  stopping = true;
+  pthread_cond_broadcast (&cond);
+  pthread_mutex_unlock (&mutex);
+
+  rep (ii, threads.size ()) pthread_join (threads [ii], NULL);
+  rep (ii, helpers.size ()) {
+    delete helpers [ii]->uct;
+    delete helpers [ii];
+  }
+  pthread_cond_destroy (&cond);
+  pthread_mutex_destroy (&mutex);
+}
+
+uint RootParallel::helper_cnt () const {
+  return helpers.size ();
+}
+
+void* RootParallel::helper_main (void* helper_ptr) {
+  Helper*       helper = (Helper*) helper_ptr;
+  RootParallel* owner  = helper->owner;
+  uint          seen_generation = 0;
+
+  thread_node_pool ();
+  set_thread_random_stream (1000 + helper->idx); // away from host workers
+  helper->uct = new Uct (helper->board);
+
+  pthread_mutex_lock (&owner->mutex);
+  while (true) {
+    while (owner->generation == seen_generation && !owner->stopping)
+      pthread_cond_wait (&owner->cond, &owner->mutex);
+    if (owner->stopping) break;
+    seen_generation = owner->generation;
+
+    pthread_mutex_unlock (&owner->mutex);
+    owner->helper_search (helper);
+    pthread_mutex_lock (&owner->mutex);
+
+    owner->done_cnt++;
+    pthread_cond_broadcast (&owner->cond);
+  }
+  pthread_mutex_unlock (&owner->mutex);
+  return NULL;
+}
+
+// base_board of the master does not change during its search
+void RootParallel::helper_search (Helper* helper) {
+  Uct* uct = helper->uct;
+  helper->board.load (&master->base_board);
+  uct->params             = master->params;
+  uct->playout_extra_komi = master->playout_extra_komi;
+  uct->interrupt          = master->interrupt;
+
+  uct->root_ensure_children_legality (player);
+  uint done_cnt = 0;
+  while (done_cnt < playout_cnt && !uct->interrupted ())
+    done_cnt += uct->do_playout (player);
+}
+
+void RootParallel::merge (Uct& master, Uct& helper) {
+  assertc (uct_ac, master.tree.is_valid ());
+  assertc (uct_ac, helper.tree.is_valid ());
+
+  Node* root        = master.tree.history [0];
+  Node* helper_root = helper.tree.history [0];
+
+  root->stat.merge (helper_root->stat);
+  node_for_each_child (helper_root, helper_child, {
+    Node* child = root->children [helper_child->v];
+    if (child != NULL) child->stat.merge (helper_child->stat);
+  });
+}
+
+void RootParallel::search (Uct& master_, Player player_, uint playout_cnt_) {
+  pthread_mutex_lock (&mutex);
+  master      = &master_;
+  player      = player_;
+  playout_cnt = playout_cnt_;
+  done_cnt    = 0;
+  generation++;
+  pthread_cond_broadcast (&cond);
+  pthread_mutex_unlock (&mutex);
+
+  uint master_cnt = 0;
+  while (master_cnt < playout_cnt && !master->interrupted ())
+    master_cnt += master->do_playout (player);
+
+  pthread_mutex_lock (&mutex);
+  while (done_cnt < helpers.size ()) pthread_cond_wait (&cond, &mutex);
+  pthread_mutex_unlock (&mutex);
+
+  rep (ii, helpers.size ()) merge (*master, *helpers [ii]->uct);
+}
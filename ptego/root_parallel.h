@@ -0,0 +1,52 @@
+#ifndef _ROOT_PARALLEL_H_
+#define _ROOT_PARALLEL_H_
+
+#include <pthread.h>
+#include <vector>
+
+class Uct;
+
+// Root parallel search (--root-parallel): helper threads search the
+// position of a Uct independently, each with its own tree, node pool and
+// random stream, and at the end the statistics of their root children
+// are added to the tree of that Uct. Nothing is shared while searching,
+// so there is no locking and each helper touches only its own memory.
+
+class RootParallel {
+public:
+  RootParallel (uint helper_cnt);
+  ~RootParallel ();
+
+  uint helper_cnt () const;
+
+  // master searches playout_cnt times, and so does every helper
+  void search (Uct& master, Player player, uint playout_cnt);
+
+private:
+  struct Helper {
+    RootParallel*  owner;
+    uint           idx;
+    Board          board;
+    Uct*           uct;
+  };
+
+  static void* helper_main (void* helper_ptr);
+  void helper_search (Helper* helper);
+  void merge (Uct& master, Uct& helper);
+
+  std::vector <Helper*>    helpers;
+  std::vector <pthread_t>  threads;
+
+  pthread_mutex_t  mutex;
+  pthread_cond_t   cond;
+  uint             generation;  // one for each search
+  uint             done_cnt;
+  bool             stopping;
+
+  // of the current search
+  Uct*             master;
+  Player           player;
+  uint             playout_cnt;
+};
+
+#endif
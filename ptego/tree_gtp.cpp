@@ -0,0 +1,97 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// ----------------------------------------------------------------------
+
+// uct.tree.show [max_depth] [max_width] [text|json]
+// uct.tree.save <file>
+// uct.tree.load <file>
+//
+// The search tree of the genmove engine: the most visited part of it
+// as text or json (Tree::to_string, children below UctParams::min_visit are
+// left out), or a binary snapshot (Tree::save). A loaded tree is resumed
+// by the next genmove or lz-analyze on the same position and komi;
+// elsewhere it is dropped.
+
+class TreeGtp : public GtpCommand {
+public:
+  Gtp&              gtp;
+  GenmoveGtp<Uct>&  genmove_gtp;
+
+  uint  default_max_depth;
+  uint  default_max_width;
+
+public:
+  TreeGtp (Gtp& gtp_, GenmoveGtp<Uct>& genmove_gtp_)
+    : gtp (gtp_), genmove_gtp (genmove_gtp_)
+  {
+    default_max_depth = 2;
+    default_max_width = 5;
+
+    gtp.add_gtp_command (this, "uct.tree.show");
+    gtp.add_gtp_command (this, "uct.tree.save");
+    gtp.add_gtp_command (this, "uct.tree.load");
+  }
+
+  virtual GtpResult exec_command (const string& command, istream& params) {
+    if (command == "uct.tree.show") {
+      uint   max_depth = default_max_depth;
+      uint   max_width = default_max_width;
+      string format    = "text";
+
+      string token;
+      uint   number_cnt = 0;
+      while (params >> token) {
+        if (token == "text" || token == "json") { format = token; continue; }
+        uint value;
+        if (!string_to<uint> (token, &value) || number_cnt == 2)
+          return GtpResult::syntax_error ();
+        (number_cnt++ == 0 ? max_depth : max_width) = value;
+      }
+
+      Uct* uct = genmove_gtp.get_engine ();
+      if (!uct->tree.is_valid ()) return GtpResult::failure ("no tree");
+      return GtpResult::success (uct->tree.to_string (max_depth, max_width,
+                                                      uct->params.min_visit,
+                                                      uct->params.min_visit_parent,
+                                                      format == "json"));
+    }
+
+    string file_name;
+    if (!(params >> file_name)) return GtpResult::syntax_error ();
+
+    if (command == "uct.tree.save") {
+      if (!genmove_gtp.get_engine ()->save_tree (file_name))
+        return GtpResult::failure ("no tree or cannot write: " + file_name);
+      return GtpResult::success ();
+    }
+
+    if (command == "uct.tree.load") {
+      if (!genmove_gtp.get_engine ()->load_tree (file_name))
+        return GtpResult::failure ("cannot load tree: " + file_name);
+      return GtpResult::success ();
+    }
+
+    assert (false);
+  }
+};
@@ -21,15 +21,52 @@
  *                                                                           *
 \* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-#include "stat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atomic_stat.h"
+#include "move_prior.h"
+#include "root_parallel.h"
 
 // uct parameters
 
+// Size of the node pool of every search thread. The host mode (host.cpp)
+// fits it to its memory budget.
+uint uct_max_nodes = 1000000;
+bool uct_huge_pages = false;
+bool uct_prefault_pool = false;
+
+// threads of a genmove search, more than one searches root parallel
+uint uct_root_thread_cnt = 1;
+
+// UCB1-Tuned selection (AtomicStat::ucb_tuned) instead of plain UCB1
+bool uct_ucb1_tuned = false;
+
+// Playouts from every leaf reached by a descent, backed up together.
+uint uct_leaf_playout_cnt = 1;
+
+// Bound of dynamic komi (Uct::extra_komi) in points, 0 - off.
+float uct_dynamic_komi_max = 0.0;
+
+// New children start with virtual wins and losses of MovePrior::prior.
+bool uct_prior_knowledge = false;
+
+// Progressive widening: a node gets the uct_widening_base strongest
+// children (MovePrior) when it matures and one more each time its
+// visits grow uct_widening_factor times. 0 - all children at once.
+uint  uct_widening_base   = 0;
+float uct_widening_factor = 1.4;
 
 // ----------------------------------------------------------------------
 class Node {
 public:
-  Stat stat;
+  AtomicStat stat;
 #ifdef USE_PLAYOUT_VIEW
 	PlayoutView *view; // Trzymamy wskaznik, zeby nie alokowac zbyt wiele pamieci
 #endif
@@ -40,14 +77,11 @@ public:
   // TODO this should be replaced by Stat
   FastMap<Vertex, Node*> children;
   bool have_child;
+  uint child_cnt;
+  bool widened_all;    // no moves left to add as children
+  float next_widening; // update_count at which the node may get wider
 
 public:
-	~Node(void) { 
-#ifdef USE_PLAYOUT_VIEW
-		if (view) delete view; 
-#endif
-	}
-
   #define node_for_each_child(node, act_node, i) do {       \
     assertc (tree_ac, node!= NULL);                         \
     Node* act_node;                                         \
@@ -61,32 +95,41 @@ public:
   void init (Player pl, Vertex v) {
     this->player = pl;
     this->v = v;
+    stat.reset ();
     vertex_for_each_all (v) {
       children[v] = NULL;
 		}
-    have_child = false;
+    have_child  = false;
+    child_cnt   = 0;
+    widened_all = false;
+    next_widening = 0.0;
 
 #ifdef USE_PLAYOUT_VIEW
-		view = NULL; // TODO : Czy mi tu jakas pamiec nie cieknie ??
+		// Pula nie wola destruktorow, widok poprzedniego wezla zwalniamy
+		// tutaj (pamiec puli jest na poczatku wyzerowana).
+		if (view) delete view;
+		view = NULL;
 #endif
   }
 
   void add_child (Node* new_child) { // TODO sorting?
     have_child = true;
     // TODO assert
+    if (children[new_child->v] == NULL) child_cnt++;
     children[new_child->v] = new_child;
   }
 
   void remove_child (Node* del_child) { // TODO inefficient
     assertc (tree_ac, del_child != NULL);
     children[del_child->v] = NULL;
+    child_cnt--;
   }
 
   bool no_children () {
     return !have_child;
   }
 
-  Node* find_uct_child (Board *b, float explore_rate) {
+  Node* find_uct_child (Board *b, float explore_rate, bool ucb1_tuned) {
     Node* best_child = NULL;
     float best_urgency = -large_float;
     float explore_coeff = log (stat.update_count()) * explore_rate;
@@ -150,12 +193,18 @@ public:
 #ifdef USE_PLAYOUT_VIEW
 				( (view) ? (*view)[x] : 0 ) + 
 #endif
+				(ucb1_tuned ? child->stat.ucb_tuned (
+						child->player, 
+#ifdef USE_UCT_LOCALITY
+						factor[x] * 
+#endif	
+						explore_coeff) :
 				child->stat.ucb (
 						child->player, 
 #ifdef USE_UCT_LOCALITY
 						factor[x] * 
 #endif	
-						explore_coeff);
+						explore_coeff));
       
 			if (child_urgency > best_urgency) {
         best_urgency  = child_urgency;
@@ -183,85 +232,85 @@ public:
     assertc (tree_ac, best_child != NULL);
     return best_child;
   }
+};
 
-  void rec_print (ostream& out, uint depth,
-                  float min_visit, float min_visit_parent) {
-    rep (d, depth) out << "  ";
-    out 
-      << player.to_string () << " " 
-      << v.to_string () << " " 
-      << stat.to_string() << " "
-      << endl;
 
-    rec_print_children (out, depth, min_visit, min_visit_parent);
-  }
 
-  void rec_print_children (ostream& out, uint depth, 
-                           float min_visit, float min_visit_parent) {
-    Node*  child_tab [Vertex::cnt]; // rough upper bound for the number of legal move
-    uint     child_tab_size;
-    uint     best_child_idx;
-    float    min_visit_cnt;
-    
-    child_tab_size  = 0;
-    best_child_idx  = 0;
-    min_visit_cnt   =
-      min_visit + 
-      stat.update_count() * min_visit_parent; 
-    // we want to be visited at least some percentage of parent's visit_cnt
-
-    // prepare for selection sort
-    node_for_each_child (this, child, child_tab [child_tab_size++] = child);
-
-    #define best_child child_tab [best_child_idx]
-
-    while (child_tab_size > 0) {
-      // find best child
-      rep(ii, child_tab_size) {
-        if ((player == Player::black ()) == 
-            (best_child->stat.mean() > child_tab [ii]->stat.mean()))
-          best_child_idx = ii;
-      }
-      // rec call
-      if (best_child->stat.update_count() >= min_visit_cnt)
-        child_tab [best_child_idx]->rec_print (out, depth + 1,
-                                               min_visit, min_visit_parent);
-      else break;
-
-      // remove best
-      best_child = child_tab [--child_tab_size];
-    }
+// ordering for root snapshots and tree exports, most visited first
+inline bool more_visited (Node* a, Node* b) {
+  return a->stat.update_count () > b->stat.update_count ();
+}
 
-    #undef best_child
-    
-  }
+// Node pools are by far the biggest allocation, so every search thread
+// allocates one for the lifetime of the process. A Tree is valid until
+// the next Tree::init on the same thread.
+
+FastPool<Node>* thread_node_pool () {
+  static thread_local_pod FastPool<Node>* pool = NULL;
+  if (pool == NULL)
+    pool = new FastPool<Node> (uct_max_nodes, uct_huge_pages, uct_prefault_pool);
+  return pool;
+}
+
+// The Tree the pool of this thread belongs to, set by Tree::init and
+// Tree::load. Trees keep the address of the slot, so validity can be
+// checked from other threads too (RootParallel::merge).
+
+static thread_local_pod void* node_pool_owner = NULL;
+
+// Binary tree snapshot (uct.tree.save / uct.tree.load): a header and one
+// record per node in breadth first order, so children of a node are
+// consecutive records. Loading maps the file and fills one contiguous
+// block of the node pool in a single pass. Playout views are not saved.
+
+struct TreeFileHeader {
+  char        magic [8];    // "EGOTREE3"
+  uint32_t    node_cnt;
+  float       komi;
+  uint64      root_key;     // OpeningBook::key of the root position
 };
 
+struct TreeFileNode {
+  AtomicStat  stat;
+  uint32_t    first_child;  // record index
+  uint16_t    child_cnt;
+  uint16_t    v;            // Vertex::get_idx
+  uint32_t    player;       // Player::get_idx
+};
 
+static const char tree_file_magic [8] = { 'E', 'G', 'O', 'T', 'R', 'E', 'E', '3' };
 
 // class Tree
 
 class Tree {
 
   static const uint uct_max_depth = 1000;
-  static const uint uct_max_nodes = 1000000;
 
 public:
 
-  FastPool <Node> node_pool;
-  Node*           history [uct_max_depth];
-  uint            history_top;
+  FastPool <Node>* node_pool;
+  void**           pool_owner;   // node_pool_owner of the pool's thread
+  Node*            history [uct_max_depth];
+  uint             history_top;
 
 public:
 
-  Tree () : node_pool(uct_max_nodes) {
+  Tree () : node_pool (NULL), pool_owner (NULL) {
   }
 
   void init (Player pl) {
-    node_pool.reset();
-    history [0] = node_pool.malloc ();
+    node_pool = thread_node_pool ();
+    node_pool->reset();
+    history [0] = node_pool->malloc ();
     history [0]->init (pl.other(), Vertex::any ());
     history_top = 0;
+    pool_owner  = &node_pool_owner;
+    *pool_owner = this;
+  }
+
+  // false once another tree took over the pool
+  bool is_valid () const {
+    return node_pool != NULL && *pool_owner == this;
   }
 
   void history_reset () {
@@ -272,30 +321,61 @@ public:
     return history [history_top];
   }
   
-  void uct_descend (Board *board, float explore_rate) {
-    history [history_top + 1] = act_node ()->find_uct_child (board, explore_rate);
+  void uct_descend (Board *board, float explore_rate, bool ucb1_tuned) {
+    profile_start (profile_find_uct_child);
+    history [history_top + 1] = act_node ()->find_uct_child (board, explore_rate, ucb1_tuned);
+    profile_stop (profile_find_uct_child);
     history_top++;
     assertc (tree_ac, act_node () != NULL);
   }
   
-  void alloc_child (Vertex v) {
+  // seed - prior knowledge for the stat of the child, or NULL
+  void alloc_child (Vertex v, MovePrior* seed = NULL) {
     Node* new_node;
-    new_node = node_pool.malloc ();
+    new_node = node_pool->malloc ();
     new_node->init (act_node()->player.other(), v);
+    if (seed != NULL) {
+      uint  visit_cnt;
+      float mean;
+      seed->prior (v, &visit_cnt, &mean);
+      if (new_node->player != Player::black ()) mean = -mean;
+      new_node->stat.reset (visit_cnt, mean);
+    }
     act_node ()->add_child (new_node);
   }
   
+  // adds the (at most) cnt strongest moves of board that are not
+  // children of the act node yet, returns how many were added
+  uint add_strongest_children (Board* board, Player pl, uint cnt, bool seed) {
+    MovePrior prior (board, pl);
+    Node* node = act_node ();
+    pair <float, uint> moves [Vertex::cnt]; // strength, vertex
+    uint move_cnt = 0;
+
+    empty_v_for_each_and_pass (board, v, {
+      if (node->children [v] == NULL) {
+        float strength = prior.strength (v);
+        if (strength > 0.0) moves [move_cnt++] = make_pair (strength, v.get_idx ());
+      }
+    });
+
+    cnt = min (cnt, move_cnt);
+    partial_sort (moves, moves + cnt, moves + move_cnt, greater <pair <float, uint> > ());
+    rep (ii, cnt) alloc_child (Vertex (moves [ii].second), seed ? &prior : NULL);
+    return cnt;
+  }
+
   void delete_act_node () {
     assertc (tree_ac, act_node ()->no_children ());
     assertc (tree_ac, history_top > 0);
     history [history_top-1]->remove_child (act_node ());
-    node_pool.free (act_node ());
+    node_pool->free (act_node ());
   }
   
   void free_subtree (Node* parent) {
     node_for_each_child (parent, child, {
       free_subtree (child);
-      node_pool.free (child);
+      node_pool->free (child);
     });
   }
 
@@ -317,67 +397,391 @@ public:
   }
 #endif
 
-  string to_string (float min_visit, float min_visit_parent) { 
-    ostringstream out_str;
-    history [0]->rec_print (out_str, 0, min_visit, min_visit_parent); 
-    return out_str.str ();
+  // cnt samples (of playouts from one leaf) in one pass
+  void update_history (float sample_sum, float square_sample_sum, uint cnt) {
+    rep (hi, history_top+1) {
+      history [hi]->stat.update (sample_sum, square_sample_sum, cnt);
+    }
   }
-};
 
+#ifdef USE_PLAYOUT_VIEW
+  void update_history_views (Board *board) {
+    rep (hi, history_top+1) {
+      if (!history [hi]->view) history [hi]->view = new PlayoutView();
+      history [hi]->view->update (board, board->winner());
+    }
+  }
+#endif
 
- // class Uct
+  bool save (const string& file_name, float komi, uint64 root_key) {
+    vector <Node*>        order;
+    vector <TreeFileNode> records;
+    order.push_back (history [0]);
+
+    for (uint ii = 0; ii < order.size (); ii++) { // order grows on the way
+      Node* node = order [ii];
+      TreeFileNode record;
+      record.stat        = node->stat;
+      record.first_child = order.size ();
+      record.child_cnt   = 0;
+      record.v           = node->v.get_idx ();
+      record.player      = node->player.get_idx ();
+      node_for_each_child (node, child, {
+        order.push_back (child);
+        record.child_cnt++;
+      });
+      records.push_back (record);
+    }
 
+    TreeFileHeader header;
+    memcpy (header.magic, tree_file_magic, sizeof (header.magic));
+    header.node_cnt = records.size ();
+    header.komi     = komi;
+    header.root_key = root_key;
+
+    FILE* out = fopen (file_name.c_str (), "wb");
+    if (out == NULL) return false;
+    bool ok =
+      fwrite (&header, sizeof (header), 1, out) == 1 &&
+      fwrite (&records [0], sizeof (TreeFileNode), records.size (), out) == records.size ();
+    return fclose (out) == 0 && ok;
+  }
+
+  // replaces the tree; on failure the old one is left untouched
+  bool load (const string& file_name, float* komi, uint64* root_key) {
+    int fd = open (file_name.c_str (), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat (fd, &st) != 0 || uint64 (st.st_size) < sizeof (TreeFileHeader)) {
+      ::close (fd);
+      return false;
+    }
+    void* data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    if (data == MAP_FAILED) return false;
+
+    const TreeFileHeader* header  = (const TreeFileHeader*) data;
+    const TreeFileNode*   records = (const TreeFileNode*) (header + 1);
+    uint node_cnt = header->node_cnt;
+
+    bool ok =
+      memcmp (header->magic, tree_file_magic, sizeof (header->magic)) == 0 &&
+      node_cnt > 0 &&
+      uint64 (st.st_size) == sizeof (TreeFileHeader) + uint64 (node_cnt) * sizeof (TreeFileNode) &&
+      node_cnt <= thread_node_pool ()->size ();
+
+    // breadth first order, exactly as save writes it: the children of
+    // each record follow those of the previous one, after the parent,
+    // so every node but the root is linked once
+    uint64 next_child = 1;
+    for (uint ii = 0; ok && ii < node_cnt; ii++) {
+      const TreeFileNode& record = records [ii];
+      ok = record.v < Vertex::cnt && record.player < Player::cnt &&
+        record.first_child == next_child &&
+        (record.child_cnt == 0 || record.first_child > ii);
+      next_child += record.child_cnt;
+    }
+    ok = ok && next_child == node_cnt;
+
+    if (ok) {
+      node_pool = thread_node_pool ();
+      node_pool->reset ();
+      Node* nodes = node_pool->malloc_bulk (node_cnt);
+
+      rep (ii, node_cnt) {
+        nodes [ii].init (Player (records [ii].player), Vertex (records [ii].v));
+        nodes [ii].stat = records [ii].stat;
+      }
+      rep (ii, node_cnt) {
+        rep (ci, records [ii].child_cnt)
+          nodes [ii].add_child (nodes + records [ii].first_child + ci);
+      }
+
+      history [0] = nodes;
+      history_top = 0;
+      pool_owner  = &node_pool_owner;
+      *pool_owner = this;
+      *komi     = header->komi;
+      *root_key = header->root_key;
+    }
+
+    munmap (data, st.st_size);
+    return ok;
+  }
+
+  // Root and its most visited descendants, at most max_width children
+  // of a node and max_depth levels below the root. A child is shown
+  // when visited min_visit times plus min_visit_parent of its parent
+  // visits. Text is one indented line per node, json nests "children".
+  string to_string (uint max_depth, uint max_width,
+                    float min_visit, float min_visit_parent, bool json = false) {
+    ostringstream out;
+    print_node (out, history [0], 0, max_depth, max_width,
+                min_visit, min_visit_parent, json);
+    return out.str ();
+  }
+
+private:
+
+  void print_node (ostream& out, Node* node, uint depth, uint max_depth, uint max_width,
+                   float min_visit, float min_visit_parent, bool json) {
+    if (json) {
+      char mean [20];
+      sprintf (mean, "%.4f", node->stat.mean ());
+      out << "{\"move\":\"" << node->v.to_string ()
+          << "\",\"player\":\"" << node->player.to_string ()
+          << "\",\"visits\":" << uint (node->stat.update_count ())
+          << ",\"mean\":" << mean;
+    } else {
+      rep (d, depth) out << "  ";
+      out << node->player.to_string () << " "
+          << node->v.to_string () << " "
+          << node->stat.to_string () << endl;
+    }
+
+    // O(k log k) for the k children shown
+    Node* children [Vertex::cnt];
+    uint  child_cnt = 0;
+    float min_visit_cnt = min_visit + node->stat.update_count () * min_visit_parent;
+    if (depth < max_depth) {
+      node_for_each_child (node, child, {
+        if (child->stat.update_count () >= min_visit_cnt) children [child_cnt++] = child;
+      });
+    }
+    uint shown_cnt = min (max_width, child_cnt);
+    partial_sort (children, children + shown_cnt, children + child_cnt, more_visited);
+
+    if (json && shown_cnt > 0) out << ",\"children\":[";
+    rep (ii, shown_cnt) {
+      if (json && ii > 0) out << ",";
+      print_node (out, children [ii], depth + 1, max_depth, max_width,
+                  min_visit, min_visit_parent, json);
+    }
+    if (json && shown_cnt > 0) out << "]";
+    if (json) out << "}";
+  }
 
-class Uct {
 public:
 
+  // most explored line starting at (and including) node
+  string principal_variation (Node* node, float min_visit, uint max_length) {
+    ostringstream out;
+    rep (ii, max_length) {
+      out << (ii > 0 ? " " : "") << node->v.to_string ();
+      if (node->no_children ()) break;
+      node = node->find_most_explored_child ();
+      if (node->stat.update_count () < min_visit) break;
+    }
+    return out.str ();
+  }
+};
+
+
+
+
+// Search parameters of a Uct, defaults from the uct_* globals. Root
+// parallel helpers and match sides get them in one assignment, so a new
+// parameter only has to be added here.
+
+class UctParams {
+public:
   float explore_rate;
-  uint  uct_genmove_playout_cnt;
+  bool  ucb1_tuned;
+  uint  genmove_playout_cnt;
   float mature_update_count_threshold;
 
+  uint  widening_base;     // 0 - no progressive widening
+  float widening_factor;
+  bool  prior_knowledge;
+  uint  leaf_playout_cnt;
+
+  // see Uct::extra_komi
+  float dynamic_komi_max;    // 0 - off
+  float dynamic_komi_step;
+  float dynamic_komi_low;    // win rates of the player to move, 0 .. 1
+  float dynamic_komi_high;
+
   float min_visit;
   float min_visit_parent;
 
   float resign_mean;
 
+  uint  root_thread_cnt;
+
+  UctParams () {
+    explore_rate                   = 1.0;
+    ucb1_tuned                     = uct_ucb1_tuned;
+    genmove_playout_cnt            = 100000;
+    mature_update_count_threshold  = 100.0;
+    widening_base                  = uct_widening_base;
+    widening_factor                = uct_widening_factor;
+    prior_knowledge                = uct_prior_knowledge;
+    leaf_playout_cnt               = uct_leaf_playout_cnt;
+
+    dynamic_komi_max    = uct_dynamic_komi_max;
+    dynamic_komi_step   = 1.0;
+    dynamic_komi_low    = 0.45;
+    dynamic_komi_high   = 0.65;
+
+    min_visit         = 500.0;
+    min_visit_parent  = 0.02;
+
+    resign_mean = 0.95;
+
+    root_thread_cnt = uct_root_thread_cnt;
+  }
+};
+
+
+ // class Uct
+
+
+class Uct {
+public:
+
+  UctParams params;
+
+  // Dynamic komi: genmove searches with the komi of the board moved by
+  // extra_komi points for white. After each genmove it moves a step
+  // against the player whose best move wins more often than
+  // dynamic_komi_high (or for the player below dynamic_komi_low), so
+  // lopsided and handicap positions keep win rates that tell moves
+  // apart. A new game (fewer moves than before) starts from 0.
+  float extra_komi;
+  uint  extra_komi_move_no;
+  float playout_extra_komi;  // of the running search
+
+  // set by the gtp front end, search stops early when it goes up
+  const volatile bool* interrupt;
+
   Board&        base_board;
   Tree          tree;      // TODO sync tree->root with base_board
-  ExtPolicy  policy;
+  FastRandom*   random;    // of the thread running the search
+
+  // root position of the tree; a loaded tree is resumed by the next
+  // search of that position instead of starting from scratch
+  uint64        tree_key;
+  float         tree_komi;
+  bool          tree_resume;
+
+  RootParallel* root_parallel;   // helpers, created by the first search
 
   Board play_board;
+  Board leaf_board;  // of the playouts after the first one from a leaf
   
 public:
   
-  Uct (Board& base_board_) : base_board (base_board_), policy(global_random) { 
-    explore_rate                   = 1.0;
-    uct_genmove_playout_cnt        = 100000;
-    mature_update_count_threshold  = 100.0;
+  Uct (Board& base_board_) : base_board (base_board_), random (&global_random) { 
+    extra_komi          = 0.0;
+    extra_komi_move_no  = 0;
+    playout_extra_komi  = 0.0;
 
-    min_visit         = 500.0;
-    min_visit_parent  = 0.02;
+    interrupt = NULL;
 
-    resign_mean = 0.95;
+    tree_key    = 0;
+    tree_komi   = 0.0;
+    tree_resume = false;
+
+    root_parallel = NULL;
+  }
+
+  ~Uct () {
+    delete root_parallel;
+  }
+
+  bool interrupted () {
+    return interrupt != NULL && *interrupt;
   }
 
   void root_ensure_children_legality (Player pl) {
     // cares about superko in root (only)
+    random = &thread_random ();
+
+    uint64 key = OpeningBook::key (&base_board, pl);
+    if (tree_resume && tree.is_valid () &&
+        tree_key == key && tree_komi == search_komi ()) {
+      tree_resume = false;
+      tree.history_reset ();
+      tree.act_node ()->widened_all = true;
+      return;
+    }
+
     tree.init(pl);
+    tree_key    = key;
+    tree_komi   = search_komi ();
+    tree_resume = false;
 
     assertc (uct_ac, tree.history_top == 0);
     assertc (uct_ac, tree.act_node ()->no_children());
 
-    empty_v_for_each_and_pass (&base_board, v, {
-      if (base_board.is_strict_legal (pl, v))
-        tree.alloc_child (v);
-    });
+    if (params.prior_knowledge) {
+      MovePrior prior (&base_board, pl);
+      empty_v_for_each_and_pass (&base_board, v, {
+        if (base_board.is_strict_legal (pl, v)) tree.alloc_child (v, &prior);
+      });
+    } else {
+      empty_v_for_each_and_pass (&base_board, v, {
+        if (base_board.is_strict_legal (pl, v)) tree.alloc_child (v);
+      });
+    }
+    tree.act_node ()->widened_all = true; // widening would add illegal moves
   }
 
+  // Board::komi of the playouts
+  float search_komi () {
+    return base_board.komi () - playout_extra_komi;
+  }
+
+  void update_extra_komi (Player player, float mean) {
+    float win_rate = ((player == Player::black () ? mean : -mean) + 1.0) / 2.0;
+    float step = player == Player::black () ? params.dynamic_komi_step : -params.dynamic_komi_step;
+    if (win_rate > params.dynamic_komi_high) extra_komi += step;
+    if (win_rate < params.dynamic_komi_low)  extra_komi -= step;
+    extra_komi = max (-params.dynamic_komi_max, min (params.dynamic_komi_max, extra_komi));
+  }
+
+  // children a node may have after n visits
+  uint widening_width (float n) {
+    if (n <= params.mature_update_count_threshold) return params.widening_base;
+    return params.widening_base +
+      uint (log (n / params.mature_update_count_threshold) / log (params.widening_factor));
+  }
+
+  // visits after which widening_width exceeds width
+  float widening_visits (uint width) {
+    return params.mature_update_count_threshold *
+      pow (params.widening_factor, float (width + 1 - params.widening_base));
+  }
+
+  // called on every descent, so the logarithms are taken only when the
+  // visits reach the threshold kept in the node
+  void widen_act_node (Player pl) {
+    Node* node = tree.act_node ();
+    if (node->widened_all) return;
+    float visits = node->stat.update_count ();
+    if (visits < node->next_widening) return;
+    uint width = widening_width (visits);
+    node->next_widening = widening_visits (width);
+    if (node->child_cnt >= width) return;
+    uint add_cnt = width - node->child_cnt;
+    if (!tree.node_pool->can_malloc (add_cnt)) return;
+    if (tree.add_strongest_children (&play_board, pl, add_cnt, params.prior_knowledge) < add_cnt)
+      node->widened_all = true;
+  }
+
+  // Returns the number of playouts backed up, leaf_playout_cnt or 1
+  // when the descent ended the game. A descent that finds an illegal
+  // move in the tree deletes it and counts as 1 as well.
   flatten 
-  void do_playout (Player first_player){
+  uint do_playout (Player first_player){
     Player act_player = first_player;
     Vertex v;
     
+    profile_start (profile_board_load);
     play_board.load (&base_board);
+    if (playout_extra_komi != 0.0) play_board.set_komi (search_komi ());
+    profile_stop (profile_board_load);
     tree.history_reset ();
     
     do {
@@ -385,56 +789,94 @@ public:
         
         // If the leaf is ready expand the tree -- add children - 
         // all potential legal v (i.e.empty)
+        // When the pool is exhausted leaves just stay leaves.
         if (tree.act_node()->stat.update_count() >
-            mature_update_count_threshold) 
+            params.mature_update_count_threshold &&
+            tree.node_pool->can_malloc (play_board.empty_v_cnt + 1)) 
         {
-          empty_v_for_each_and_pass (&play_board, v, {
-            tree.alloc_child (v); // TODO simple ko should be handled here
-            // (suicides and ko recaptures, needs to be dealt with later)
-          });
+          profile_start (profile_expand);
+          if (params.widening_base > 0) {
+            widen_act_node (act_player); // at least pass
+          } else if (params.prior_knowledge) {
+            MovePrior prior (&play_board, act_player);
+            empty_v_for_each_and_pass (&play_board, v, tree.alloc_child (v, &prior));
+          } else {
+            empty_v_for_each_and_pass (&play_board, v, {
+              tree.alloc_child (v); // TODO simple ko should be handled here
+              // (suicides and ko recaptures, needs to be dealt with later)
+            });
+          }
+          profile_stop (profile_expand);
           continue;            // try again
         }
         
-        Playout<ExtPolicy> (&policy, &play_board).run ();
-
-        int score = play_board.winner().get_idx (); // black -> 0, white -> 1
-			
-				// black -> 1, white -> -1
+        // later playouts start from a copy of the leaf, not of the root
+        uint  playout_cnt = max (params.leaf_playout_cnt, uint (1));
+        float sample_sum  = 0.0;
+        if (playout_cnt > 1) leaf_board.load (&play_board);
+
+        rep (ii, playout_cnt) {
+          if (ii > 0) {
+            profile_start (profile_board_load);
+            play_board.load (&leaf_board);
+            profile_stop (profile_board_load);
+          }
+
+          ExtPolicy policy (*random);
+          profile_start (profile_playout);
+          Playout<ExtPolicy> (&policy, &play_board).run ();
+          profile_stop (profile_playout);
+
+          profile_start (profile_score);
+          int score = play_board.winner().get_idx (); // black -> 0, white -> 1
+          profile_stop (profile_score);
+
+          sample_sum += 1 - score - score; // black -> 1, white -> -1
 #ifdef USE_PLAYOUT_VIEW
-				if (!tree.act_node()->view) 
-					tree.act_node()->view = new PlayoutView();
-	
-				tree.update_history (1 - score - score, &play_board); 
-#else
-				tree.update_history (1 - score - score); 
+          profile_start (profile_update);
+          tree.update_history_views (&play_board);
+          profile_stop (profile_update);
 #endif
-        return;
+        }
+
+        profile_start (profile_update);
+        tree.update_history (sample_sum, playout_cnt, playout_cnt); // samples squared are 1
+        profile_stop (profile_update);
+        return playout_cnt;
       }
       
-      tree.uct_descend (&play_board, explore_rate);
+      if (params.widening_base > 0) {
+        profile_start (profile_widen);
+        widen_act_node (act_player);
+        profile_stop (profile_widen);
+      }
+      tree.uct_descend (&play_board, params.explore_rate, params.ucb1_tuned); // profile_find_uct_child
       v = tree.act_node ()->v;
       
-      if (play_board.is_pseudo_legal (act_player, v) == false) {
-        tree.delete_act_node ();
-        return;
+      profile_start (profile_tree_move);
+      bool legal = play_board.is_pseudo_legal (act_player, v);
+      if (legal) {
+        play_board.play_legal (act_player, v);
+        legal = play_board.last_move_status == Board::play_ok;
       }
-      
-      play_board.play_legal (act_player, v);
+      profile_stop (profile_tree_move);
 
-      if (play_board.last_move_status != Board::play_ok) {
+      if (!legal) {
         tree.delete_act_node ();
-        return;
+        return 1;
       }
 
       act_player = act_player.other();
 
       if (play_board.both_player_pass()) {
+        profile_start (profile_update);
 #ifdef USE_PLAYOUT_VIEW
         tree.update_history (play_board.tt_winner_score(), &play_board);
 #else
         tree.update_history (play_board.tt_winner_score());
 #endif
-        return;
+        profile_stop (profile_update);
+        return 1;
       }
 
     } while (true);
@@ -442,18 +884,90 @@ public:
   }
   
 
+  // lz-analyze style snapshot of max_moves most visited root children,
+  // one "info" block per move; winrate is the mean in 0..10000 scale
+  string root_info (uint max_moves, uint max_pv_length = 10) {
+    assertc (uct_ac, tree.is_valid ()); // pool not taken by another Uct
+    Node* root = tree.history [0];
+    Node* children [Vertex::cnt];
+    uint  child_cnt = 0;
+    node_for_each_child (root, child, children [child_cnt++] = child);
+
+    uint move_cnt = min (max_moves, child_cnt);
+    partial_sort (children, children + move_cnt, children + child_cnt, more_visited);
+
+    ostringstream out;
+    rep (ii, move_cnt) {
+      Node* child = children [ii];
+      float mean = child->stat.mean ();
+      if (child->player != Player::black ()) mean = -mean;
+
+      out << (ii > 0 ? " " : "")
+          << "info move " << child->v.to_string ()
+          << " visits " << uint (child->stat.update_count ())
+          << " winrate " << int ((mean + 1.0) * 5000.0)
+          << " order " << ii
+          << " pv " << tree.principal_variation (child, 2.0, max_pv_length);
+    }
+    return out.str ();
+  }
+
+  bool save_tree (const string& file_name) {
+    return tree.is_valid () && tree.save (file_name, tree_komi, tree_key);
+  }
+
+  bool load_tree (const string& file_name) {
+    if (!tree.load (file_name, &tree_komi, &tree_key)) return false;
+    tree_resume = true;
+    return true;
+  }
+
   Vertex genmove (Player player) {
 
+    if (opening_book != NULL) {
+      BookEntry entry;
+      if (opening_book->probe (&base_board, player, &entry)) {
+        Vertex v = Vertex (entry.vertex);
+        if (base_board.is_strict_legal (player, v)) return v;
+      }
+    }
+
+    if (base_board.move_no < extra_komi_move_no) extra_komi = 0.0;
+    extra_komi_move_no = base_board.move_no;
+    playout_extra_komi = params.dynamic_komi_max > 0.0 ? extra_komi : 0.0;
+
     root_ensure_children_legality (player);
 
-    rep (ii, uct_genmove_playout_cnt) do_playout (player);
+    profile_start (profile_search);
+    if (params.root_thread_cnt > 1) {
+      if (root_parallel == NULL || root_parallel->helper_cnt () + 1 != params.root_thread_cnt) {
+        delete root_parallel;
+        root_parallel = new RootParallel (params.root_thread_cnt - 1);
+        // fewer helpers when threads could not be created, kept for
+        // the next moves instead of trying again every time
+        params.root_thread_cnt = root_parallel->helper_cnt () + 1;
+      }
+      root_parallel->search (*this, player, params.genmove_playout_cnt);
+    } else {
+      uint playout_cnt = 0;
+      while (playout_cnt < params.genmove_playout_cnt && !interrupted ())
+        playout_cnt += do_playout (player);
+    }
+    profile_stop (profile_search);
     
 		Node* best = tree.history [0]->find_most_explored_child ();
     assertc (uct_ac, best != NULL);
 
-    cerr << tree.to_string (min_visit, min_visit_parent) << endl;
-    if ((player == Player::black () && best->stat.mean() < -resign_mean) ||
-        (player == Player::white () && best->stat.mean() >  resign_mean)) {
+    // a loss measured while the komi handicaps the player says nothing
+    // about the real komi; one measured with komi help is only worse
+    float komi_help = player == Player::white () ? playout_extra_komi : -playout_extra_komi;
+    bool  handicapped = komi_help < 0.0;
+    playout_extra_komi = 0.0;
+    if (params.dynamic_komi_max > 0.0) update_extra_komi (player, best->stat.sample_mean ());
+
+    if (!handicapped &&
+        ((player == Player::black () && best->stat.mean() < -params.resign_mean) ||
+         (player == Player::white () && best->stat.mean() >  params.resign_mean))) {
       return Vertex::resign ();
     }
     return best->v;
@@ -0,0 +1,250 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\
+ *                                                                           *
+ *  This file is part of Library of Effective GO routines - EGO library      *
+ *                                                                           *
+ *  Copyright 2006 and onwards, Lukasz Lew                                   *
+ *                                                                           *
+ *  EGO library is free software; you can redistribute it and/or modify      *
+ *  it under the terms of the GNU General Public License as published by     *
+ *  the Free Software Foundation; either version 2 of the License, or        *
+ *  (at your option) any later version.                                      *
+ *                                                                           *
+ *  EGO library is distributed in the hope that it will be useful,           *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+ *  GNU General Public License for more details.                             *
+ *                                                                           *
+ *  You should have received a copy of the GNU General Public License        *
+ *  along with EGO library; if not, write to the Free Software               *
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor,                           *
+ *  Boston, MA  02110-1301  USA                                              *
+ *                                                                           *
+\* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <cstdio>
+#include <pthread.h>
+
+// ----------------------------------------------------------------------
+
+// --uct-benchmark [threads] [position ...]
+//
+// Uct::genmove on every position (empty board by default), each thread
+// with its own random stream, so runs repeat exactly for a given --seed.
+// First one thread reports per position wall time, playouts per second
+// (with descent and backup), tree size and memory; then 2, 4 .. threads
+// run independent searches at once to show how the search scales.
+// Workers live through the whole benchmark, so every thread allocates
+// its node pool once, as in host mode.
+
+class UctBenchmark {
+public:
+  struct Result {
+    double  seconds;
+    uint    playouts;
+    uint    nodes;
+    uint    views;
+    uint    pool_size;
+  };
+
+  vector <string>  position_names;
+  vector <Board*>  positions;
+  uint             thread_cnt;
+
+  // per worker, per position
+  vector <vector <Result> >  results;
+
+  pthread_mutex_t  mutex;
+  pthread_cond_t   cond;
+  uint             generation;  // one for each run of active_cnt threads
+  uint             active_cnt;
+  uint             done_cnt;
+  bool             stopping;
+
+  struct WorkerArg {
+    UctBenchmark*  benchmark;
+    uint           idx;
+  };
+
+public:
+  UctBenchmark (uint thread_cnt_, const vector <string>& position_files) {
+    thread_cnt = thread_cnt_ > 0 ? thread_cnt_ : 1;
+
+    rep (ii, position_files.size ()) {
+      Board* board = new Board;
+      if (!Benchmark::load_position (position_files [ii], board)) {
+        cerr << "cannot load position: " << position_files [ii] << endl;
+        delete board;
+        continue;
+      }
+      position_names.push_back (position_files [ii]);
+      positions.push_back (board);
+    }
+    if (position_files.empty ()) {
+      position_names.push_back ("empty");
+      positions.push_back (new Board);
+    }
+
+    results.resize (thread_cnt, vector <Result> (positions.size ()));
+
+    pthread_mutex_init (&mutex, NULL);
+    pthread_cond_init (&cond, NULL);
+    generation = 0;
+    active_cnt = 0;
+    done_cnt   = 0;
+    stopping   = false;
+  }
+
+  ~UctBenchmark () {
+    rep (ii, positions.size ()) delete positions [ii];
+    pthread_cond_destroy (&cond);
+    pthread_mutex_destroy (&mutex);
+  }
+
+  static void count_nodes (Node* node, uint* nodes, uint* views) {
+    (*nodes)++;
+#ifdef USE_PLAYOUT_VIEW
+    if (node->view != NULL) (*views)++;
+#endif
+    node_for_each_child (node, child, count_nodes (child, nodes, views));
+  }
+
+  void search_all (uint idx) {
+    rep (pos, positions.size ()) {
+      Board board;
+      board.load (positions [pos]);
+      set_thread_random_stream (idx + 1);
+
+      Uct uct (board);
+      double begin = wall_clock_time ();
+      uct.genmove (board.act_player ());
+      double end = wall_clock_time ();
+
+      Result& r = results [idx] [pos];
+      r.seconds   = end - begin;
+      r.playouts  = uint (uct.tree.history [0]->stat.update_count ());
+      r.nodes     = 0;
+      r.views     = 0;
+      r.pool_size = uct.tree.node_pool->size ();
+      count_nodes (uct.tree.history [0], &r.nodes, &r.views);
+    }
+  }
+
+  static void* worker_main (void* arg_ptr) {
+    WorkerArg*    arg = (WorkerArg*) arg_ptr;
+    UctBenchmark* benchmark = arg->benchmark;
+    uint          seen_generation = 0;
+
+    thread_node_pool ();
+
+    pthread_mutex_lock (&benchmark->mutex);
+    while (true) {
+      while (benchmark->generation == seen_generation && !benchmark->stopping)
+        pthread_cond_wait (&benchmark->cond, &benchmark->mutex);
+      if (benchmark->stopping) break;
+      seen_generation = benchmark->generation;
+      if (arg->idx >= benchmark->active_cnt) continue;
+
+      pthread_mutex_unlock (&benchmark->mutex);
+      benchmark->search_all (arg->idx);
+      pthread_mutex_lock (&benchmark->mutex);
+
+      benchmark->done_cnt++;
+      pthread_cond_broadcast (&benchmark->cond);
+    }
+    pthread_mutex_unlock (&benchmark->mutex);
+    return NULL;
+  }
+
+  // wall time of active_cnt threads searching all positions
+  double run_threads (uint cnt) {
+    pthread_mutex_lock (&mutex);
+    double begin = wall_clock_time ();
+    active_cnt = cnt;
+    done_cnt   = 0;
+    generation++;
+    pthread_cond_broadcast (&cond);
+    while (done_cnt < active_cnt) pthread_cond_wait (&cond, &mutex);
+    double end = wall_clock_time ();
+    pthread_mutex_unlock (&mutex);
+    return end - begin;
+  }
+
+  string run () {
+    vector <pthread_t>  workers;
+    vector <WorkerArg>  args (thread_cnt);
+
+    rep (ii, thread_cnt) {
+      args [ii].benchmark = this;
+      args [ii].idx       = ii;
+      pthread_t thread;
+      if (pthread_create (&thread, NULL, worker_main, &args [ii]) != 0) break;
+      workers.push_back (thread);
+    }
+
+    ostringstream out;
+    char buf [300];
+
+    // single thread, per position
+    double single_wall = run_threads (1);
+    uint64 single_playouts = 0;
+
+    uint64 node_bytes = sizeof (Node);
+    uint64 view_bytes = 0;
+#ifdef USE_PLAYOUT_VIEW
+    view_bytes = sizeof (PlayoutView);
+#endif
+
+    sprintf (buf, "%-20s %8s %10s %10s %10s %7s %10s",
+             "position", "seconds", "playouts", "pps", "nodes", "pool%", "bytes/node");
+    out << buf << endl;
+    rep (pos, positions.size ()) {
+      Result& r = results [0] [pos];
+      single_playouts += r.playouts;
+      sprintf (buf, "%-20s %8.3f %10u %10.0f %10u %6.2f%% %10.0f",
+               position_names [pos].c_str (),
+               r.seconds,
+               r.playouts,
+               r.playouts / r.seconds,
+               r.nodes,
+               100.0 * r.nodes / r.pool_size,
+               double (r.nodes * node_bytes + r.views * view_bytes) / r.nodes);
+      out << buf << endl;
+    }
+    out << "sizeof (Node) " << node_bytes
+        << ", sizeof (PlayoutView) " << view_bytes
+        << ", pool " << uct_max_nodes << " nodes per thread" << endl;
+    out << endl;
+
+    // scaling
+    double single_pps = single_playouts / single_wall;
+    sprintf (buf, "%8s %8s %10s %10s %8s %10s",
+             "threads", "seconds", "playouts", "pps", "speedup", "efficiency");
+    out << buf << endl;
+    sprintf (buf, "%8u %8.3f %10llu %10.0f %8.2f %9.1f%%",
+             1, single_wall, single_playouts, single_pps, 1.0, 100.0);
+    out << buf << endl;
+
+    vector <uint> counts;
+    for (uint cnt = 2; cnt < workers.size (); cnt *= 2) counts.push_back (cnt);
+    if (workers.size () > 1) counts.push_back (workers.size ());
+
+    rep (cc, counts.size ()) {
+      uint   cnt  = counts [cc];
+      double wall = run_threads (cnt);
+      uint64 playouts = 0;
+      rep (ii, cnt) rep (pos, positions.size ()) playouts += results [ii] [pos].playouts;
+      double pps = playouts / wall;
+      sprintf (buf, "%8u %8.3f %10llu %10.0f %8.2f %9.1f%%",
+               cnt, wall, playouts, pps, pps / single_pps, 100.0 * pps / single_pps / cnt);
+      out << buf << endl;
+    }
+
+    pthread_mutex_lock (&mutex);
+    stopping = true;
+    pthread_cond_broadcast (&cond);
+    pthread_mutex_unlock (&mutex);
+    rep (ii, workers.size ()) pthread_join (workers [ii], NULL);
+
+    return out.str ();
+  }
+};